@@ -1,5 +1,7 @@
 #include "chess.h"
+#include "zobrist_keys.h"
 
+#include <assert.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
@@ -29,7 +31,7 @@ void board_init(struct board *board)
 			      | square_bb(b8) | square_bb(g8);
 	board->pieces[PAWN]   = rank_2 | rank_7;
 	board->pieces[ALL]    = rank_1 |rank_2 | rank_7 | rank_8;
-	int squares[64] = {
+	static const uint8_t squares[64] = {
 		W_ROOK, W_KNIGHT, W_BISHOP, W_QUEEN, W_KING, W_BISHOP, W_KNIGHT, W_ROOK,
 		W_PAWN, W_PAWN,   W_PAWN,   W_PAWN,  W_PAWN, W_PAWN,   W_PAWN,   W_PAWN,
 		EMPTY,  EMPTY,    EMPTY,    EMPTY,   EMPTY,  EMPTY,    EMPTY,    EMPTY,
@@ -39,9 +41,20 @@ void board_init(struct board *board)
 		B_PAWN, B_PAWN,   B_PAWN,   B_PAWN,  B_PAWN, B_PAWN,   B_PAWN,   B_PAWN,
 		B_ROOK, B_KNIGHT, B_BISHOP, B_QUEEN, B_KING, B_BISHOP, B_KNIGHT, B_ROOK
 	};
-	memcpy(board->squares, squares, 64 * sizeof(enum piece));
+	memcpy(board->squares, squares, sizeof(board->squares));
 	board->castling = ANY_CASTLING;
 	board->ep_square = SQUARES_NONE;
+	board->side = WHITE;
+	board->key = board_compute_key(board);
+	board->halfmove = 0;
+	board->ply = 0;
+	board->history = NULL;
+}
+
+void board_set_history(struct board *board, struct history *history)
+{
+	board->history = history;
+	history->count = 0;
 }
 
 void board_put_piece(struct board *board, int square, enum piece_id id)
@@ -53,6 +66,7 @@ void board_put_piece(struct board *board, int square, enum piece_id id)
 	board->colors[piece_color(id)] |= bb;
 
 	board->squares[square] = id;
+	board->key ^= zobrist_pieces[id][square];
 }
 
 void board_del_piece(struct board *board, int square)
@@ -65,6 +79,7 @@ void board_del_piece(struct board *board, int square)
 	board->colors[piece_color(id)] ^= bb;
 
 	board->squares[square] = EMPTY;
+	board->key ^= zobrist_pieces[id][square];
 }
 
 void board_move_piece(struct board *board, int from, int to)
@@ -78,6 +93,20 @@ void board_move_piece(struct board *board, int from, int to)
 
 	board->squares[from] = EMPTY;
 	board->squares[to]   = id;
+	board->key ^= zobrist_pieces[id][from] ^ zobrist_pieces[id][to];
+}
+
+// The en passant square is only hashed when a pawn of the side to move can
+// capture on it, so that a double push no pawn can take hashes like a single
+// one.
+static inline u64 ep_key(const struct board *board)
+{
+	if (board->ep_square == SQUARES_NONE)
+		return 0;
+
+	u64 pushed = square_bb(board->ep_square + ((board->side == WHITE) ? -8 : 8));
+	u64 beside = east(pushed) | west(pushed);
+	return (beside & pawns(board, board->side)) ? zobrist_ep[board->ep_square] : 0;
 }
 
 void board_move(struct board *board, move move)
@@ -86,6 +115,27 @@ void board_move(struct board *board, move move)
 	int to   = move_to(move);
 	enum color color = piece_color(board->squares[from]);
 	enum piece_id id = board->squares[from];
+	int captured = (move_is_enpassant(move)) ? to + (color == WHITE ? -8 : 8) : to;
+
+	struct history *history = board->history;
+	if (history) {
+		struct undo *undo = &history->records[board->ply & (BOARD_HISTORY - 1)];
+		undo->key       = board->key;
+		undo->captured  = (move_is_capture(move)) ? board->squares[captured] : EMPTY;
+		undo->castling  = board->castling;
+		undo->ep_square = board->ep_square;
+		undo->halfmove  = board->halfmove;
+		history->count += (history->count < BOARD_HISTORY);
+	}
+	++board->ply;
+
+	if (piece_type(id) == PAWN || move_is_capture(move))
+		board->halfmove = 0;
+	else
+		++board->halfmove;
+
+	board->key ^= zobrist_side ^ ep_key(board) ^ zobrist_castling[board->castling];
+	board->side = flip_color(board->side);
 
 	if (piece_type(id) == PAWN && pawn_double_move(from, to))
 		board->ep_square = (color == WHITE) ? to - 8 : to + 8;
@@ -102,6 +152,8 @@ void board_move(struct board *board, move move)
 	board->castling &= ~(BLACK_KINGSIDE * (from == h8 || to == h8));
 	board->castling &= ~(BLACK_QUEENSIDE * (from == a8 || to == a8));
 
+	board->key ^= zobrist_castling[board->castling];
+
 	if (move_is_castle(move)) {
 		bool kingside = to > from;
 		int king = from + ((kingside) ?  2 : -2);
@@ -112,10 +164,8 @@ void board_move(struct board *board, move move)
 		return;
 	}
 
-	if (move_is_enpassant(move))
-		board_del_piece(board, to + (color == WHITE ? -8 : 8));
-	else if (move_is_capture(move))
-		board_del_piece(board, to);
+	if (move_is_capture(move))
+		board_del_piece(board, captured);
 
 	board_move_piece(board, from, to);
 
@@ -124,15 +174,34 @@ void board_move(struct board *board, move move)
 		board_del_piece(board, to);
 		board_put_piece(board, to, make_piece(piece, color));
 	}
+
+	// whether the new en passant square is hashed depends on the pawns
+	// after the move, castling never sets one
+	board->key ^= ep_key(board);
+}
+
+void board_make_copy(struct board *dst, const struct board *src, move move)
+{
+	*dst = *src;
+	dst->history = NULL;
+	board_move(dst, move);
 }
 
-// TODO: regain castling rights?
-void board_undo_move(struct board *board, move move, enum piece_id captured)
+void board_undo_move(struct board *board, move move)
 {
 	int from = move_from(move);
 	int to   = move_to(move);
 	enum color color = piece_color(board->squares[to]);
 
+	// a record left the ring or moves were never saved
+	assert(board->history && board->history->count > 0);
+	--board->history->count;
+	const struct undo *undo = &board->history->records[--board->ply & (BOARD_HISTORY - 1)];
+	board->castling  = undo->castling;
+	board->ep_square = undo->ep_square;
+	board->halfmove  = undo->halfmove;
+	board->side      = flip_color(board->side);
+
 	if (move_is_castle(move)) {
 		bool kingside = to > from;
 		int king = from + ((kingside) ?  2 : -2);
@@ -140,18 +209,33 @@ void board_undo_move(struct board *board, move move, enum piece_id captured)
 
 		board_move_piece(board, king, from);
 		board_move_piece(board, rook, to);
-		return;
+	} else {
+		if (move_is_promotion(move)) {
+			board_del_piece(board, to);
+			board_put_piece(board, to, make_piece(PAWN, color));
+		}
+
+		board_move_piece(board, to, from);
+
+		if (move_is_enpassant(move))
+			board_put_piece(board, to + (color == WHITE ? -8 : 8), undo->captured);
+		else if (move_is_capture(move))
+			board_put_piece(board, to, undo->captured);
 	}
 
-	if (move_is_promotion(move)) {
-		board_del_piece(board, to);
-		board_put_piece(board, to, make_piece(PAWN, color));
-	}
-
-	board_move_piece(board, to, from);
+	// the pieces restored the key as they moved back, but restoring it
+	// directly is cheaper than undoing the castling and en passant keys
+	board->key = undo->key;
+}
 
-	if (move_is_enpassant(move))
-		board_put_piece(board, to + (color == WHITE ? -8 : 8), captured);
-	else if (move_is_capture(move))
-		board_put_piece(board, to, captured);
+u64 board_compute_key(const struct board *board)
+{
+	u64 key = ep_key(board) ^ zobrist_castling[board->castling];
+	if (board->side == BLACK)
+		key ^= zobrist_side;
+
+	for (int square = 0; square < 64; ++square)
+		if (board->squares[square] != EMPTY)
+			key ^= zobrist_pieces[board->squares[square]][square];
+	return key;
 }
@@ -17,10 +17,9 @@
 // movegenc serves as an auxillary struct for generating moves for a given
 // position.
 //
-// Currently, the implementation here generates pseudo-legal moves,
-// which means the moves generated do NOT ensure the king is in check, as
-// opposed to legal moves which ensure the king is not in check and that the
-// move is legal.
+// generate_moves() generates pseudo-legal moves, which means the moves
+// generated do NOT ensure the king is not left in check, as opposed to
+// generate_legal_moves() which only generates legal moves.
 
 // Module bitboard.c
 
@@ -141,6 +140,17 @@ static inline int msb(u64 bb)
 #endif
 }
 
+static inline int popcount(u64 bb)
+{
+#if   defined(__GNUC__)
+	return __builtin_popcountll(bb);
+#elif defined(_MSC_VER)
+	return (int) __popcnt64(bb);
+#else
+	#error "Compiler not supported"
+#endif
+}
+
 static inline int pop_lsb(u64 *bb)
 {
 	int i = lsb(*bb);
@@ -237,12 +247,39 @@ enum castling {
 
 // Module board.c
 
+// State a move cannot be undone without, saved by board_move().
+struct undo {
+	u64 key;
+	uint8_t captured;	// piece_id, EMPTY if none
+	uint8_t castling;
+	uint8_t ep_square;
+	uint16_t halfmove;
+};
+
+// Number of moves which can be undone, a power of two. Older moves are
+// overwritten so games of any length can be played.
+#define BOARD_HISTORY 1024
+
+// Undo records of the moves made on a board, kept apart from it so the board
+// stays small to copy.
+struct history {
+	int count;	// records which can still be undone
+	struct undo records[BOARD_HISTORY];
+};
+
+// A position fits in a few cache lines, the history is only touched by the one
+// record a move saves or restores.
 struct board {
-	enum piece_id squares[64]; // piece_id squares
 	u64 pieces[PIECE_MAX];     // piece bitboards
 	u64 colors[COLOR_MAX];     // color bitboards
-	enum castling castling;    // castling rights
-	int ep_square;
+	u64 key;                   // Zobrist hash of the position
+	uint8_t squares[64];       // piece_id squares
+	uint8_t castling;          // castling rights
+	uint8_t ep_square;
+	uint8_t side;              // side to move
+	uint16_t halfmove;         // plies since the last capture or pawn move
+	int ply;                   // moves made, indexes history
+	struct history *history;   // NULL if moves are not undone
 };
 
 #define pieces(board, piece, color) ((board)->pieces[(piece)] & (board)->colors[(color)])
@@ -250,12 +287,23 @@ struct board {
 #define can_castle(board, color, queenside) \
 	((board)->castling & (((queenside) ? WHITE_QUEENSIDE : WHITE_KINGSIDE) << 2 * (color)))
 
+// Sets up the initial position, without a history.
 void board_init(struct board *board);
+// Makes board save the moves made from now on in history, so they can be
+// undone.
+void board_set_history(struct board *board, struct history *history);
 void board_put_piece(struct board *board, int square, enum piece_id id);
 void board_del_piece(struct board *board, int square);
 void board_move_piece(struct board *board, int from, int to);
 void board_move(struct board *board, move move);
-void board_undo_move(struct board *board, move move, enum piece_id captured);
+// Takes back move, which must be the last move made and still in the history.
+void board_undo_move(struct board *board, move move);
+// Computes the Zobrist hash of the position from scratch, which board->key
+// is kept equal to as the board changes.
+u64 board_compute_key(const struct board *board);
+// Copy-make, sets dst to src after move. dst has no history, instead of undoing
+// the move it is discarded.
+void board_make_copy(struct board *dst, const struct board *src, move move);
 
 enum gentype {
 	QUIET,
@@ -273,12 +321,65 @@ struct movegenc {
 	u64 target;		// targets bitboard
 };
 
+// Room for the moves of any position, the most any has is 218.
+#define MAX_MOVES 256
+
+// Stages of a movepicker, each generates its moves only once the moves of the
+// previous one are used up.
+enum pick_stage {
+	PICK_START,
+	PICK_NOISY,	// captures and promotions, or every evasion in check
+	PICK_QUIET,
+	PICK_DONE
+};
+
+// Yields the legal moves of a position a stage at a time, see movepicker_next().
+struct movepicker {
+	const struct board *board;
+	enum color color;
+	enum pick_stage stage;
+	int king;
+	u64 checkers;
+	u64 pinned;
+	move *next, *last;
+	move moves[MAX_MOVES];
+};
 
 // Module movegen.c
 
-bool attacks_table_initilized();
-void init_lineattacks_table();
-move* generate_moves(struct board *board, move *moves, struct movegenc *conf);
-move* generate_legal_moves(struct board *board, move *moves, enum color color);
+move* generate_moves(const struct board *board, move *moves, struct movegenc *conf);
+// Generates every legal move of color, at most MAX_MOVES.
+move* generate_legal_moves(const struct board *board, move *moves, enum color color);
+// Number of legal moves of the side to move, without generating them.
+int count_legal_moves(const struct board *board);
+// Sets up picker to yield the legal moves of color, the board must not change
+// while it is in use.
+void movepicker_init(struct movepicker *picker, const struct board *board, enum color color);
+// Returns the next legal move, or 0 once there are none left. Captures and
+// promotions come before quiet moves, which are only generated when asked for.
+move movepicker_next(struct movepicker *picker);
+// Squares attacked by a bishop or rook on square, with occupied blocking.
+u64 bishop_attacks(int square, u64 occupied);
+u64 rook_attacks(int square, u64 occupied);
+// The same from the classical or magic backend selected with SLIDERS, which
+// is used when the CPU lacks PEXT.
+u64 portable_bishop_attacks(int square, u64 occupied);
+u64 portable_rook_attacks(int square, u64 occupied);
+// Pieces of either color attacking square, with occupied blocking sliders. A
+// different occupancy than the board's tells what would attack the square
+// once pieces moved, for example the king.
+u64 attackers_to(const struct board *board, int square, u64 occupied);
+// Whether a piece of by_color attacks square.
+bool is_attacked(const struct board *board, int square, enum color by_color);
+
+// Module perft.c
+
+// Number of leaf nodes of the legal move tree of board depth plies deep, which
+// is compared with known counts to test move generation. Depths below 1 count
+// board itself.
+u64 perft(const struct board *board, int depth);
+// Fills moves with the legal moves of board and nodes with the perft count
+// below each of them, both must hold MAX_MOVES. Returns the number of moves.
+int perft_divide(const struct board *board, int depth, move *moves, u64 *nodes);
 
 #endif // CHESS_H
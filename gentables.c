@@ -0,0 +1,347 @@
+#include "chess.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Generates the attack tables of movegen.c as static const data, run by the
+// Makefile to produce movegen_tables.h. The tables are computed the slow and
+// obvious way here, so movegen.c only ever looks them up. With the argument
+// "zobrist" it generates the hash keys of board.c instead, zobrist_keys.h.
+
+// Magic numbers map every blocker configuration of a square to an index
+// without destructive collisions, found by trial with a random search.
+static const u64 bishop_magic_numbers[64] = {
+	0x10102002004a1420ULL, 0x8020040400584008ULL, 0x10510800811201c8ULL, 0x5204042080000088ULL,
+	0x2204106880000002ULL, 0x1401042004000000ULL, 0x0400880410042004ULL, 0x0028208200a02020ULL,
+	0x1500241990010e00ULL, 0x8001200182020a40ULL, 0x40004101030b0000ULL, 0x8002041042000100ULL,
+	0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020a00ULL, 0x8000088400880520ULL,
+	0x0405004010040100ULL, 0x1005823210040108ULL, 0x2708008102040011ULL, 0x4048200404009100ULL,
+	0x0018104101400024ULL, 0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+	0x0006e080100c3040ULL, 0x0501044a11041800ULL, 0x9020300008004045ULL, 0x0894080000220040ULL,
+	0x1001010083104000ULL, 0x5004030040900080ULL, 0x000400422c012400ULL, 0x0002128698404812ULL,
+	0x1010108404900440ULL, 0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+	0xa010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL, 0x802a02020000b098ULL,
+	0x0009015090004060ULL, 0x4000821082081001ULL, 0x0100210040420800ULL, 0x0800004010488a00ULL,
+	0x2000081104004040ULL, 0x4c8e029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+	0x0000822802400008ULL, 0x00008a0101600000ULL, 0x3040003412080021ULL, 0x3040290220884800ULL,
+	0x4a1500401041004aULL, 0x8010200282020781ULL, 0x0020203142209091ULL, 0x0070300600902110ULL,
+	0x0040808800b62048ULL, 0x0000810400c44420ULL, 0x00080400440c0441ULL, 0x8340080020840411ULL,
+	0x0000000104208200ULL, 0x0000800810d00080ULL, 0x0400530411080200ULL, 0x4040702400932244ULL,
+};
+
+static const u64 rook_magic_numbers[64] = {
+	0x1080004008801020ULL, 0x0840092002c03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+	0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+	0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+	0x000a001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+	0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021d00100ULL,
+	0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000a0001768104ULL,
+	0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+	0x0442000a00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040a00128541ULL,
+	0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+	0x0400802402800800ULL, 0xc100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+	0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000a0020ULL,
+	0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+	0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040a00300ULL, 0x0801100280080480ULL,
+	0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+	0x0000209300488001ULL, 0x04c1002414824001ULL, 0x020020000b001041ULL, 0x7000100004200901ULL,
+	0x8002002004100802ULL, 0x30010002084c0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL,
+};
+
+// more than the rook or bishop tables need
+#define TABLE_SIZE 102400
+
+static const int bishop_dirs[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+static const int rook_dirs[4][2]   = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+
+// walks the rays of a slider square by square, until and including the first
+// occupied square
+static u64 slider_attacks(int square, u64 occupied, bool bishop)
+{
+	const int (*dirs)[2] = (bishop) ? bishop_dirs : rook_dirs;
+
+	u64 attacks = 0;
+	for (int d = 0; d < 4; ++d) {
+		int rank = square / 8 + dirs[d][0];
+		int file = square % 8 + dirs[d][1];
+		for (; rank >= 0 && rank < 8 && file >= 0 && file < 8;
+		       rank += dirs[d][0], file += dirs[d][1]) {
+			attacks |= square_bb(rank * 8 + file);
+			if (occupied & square_bb(rank * 8 + file))
+				break;
+		}
+	}
+	return attacks;
+}
+
+// edges only matter for the squares on them, a piece always attacks the edge
+// square of a ray
+static u64 relevant_blockers(int square, bool bishop)
+{
+	u64 edges = ((rank_1 | rank_8) & ~rank(square))
+	          | ((file_a | file_h) & ~file(square));
+	return slider_attacks(square, 0, bishop) & ~edges;
+}
+
+static u64 knight_attacks(int square)
+{
+	u64 target = square_bb(square);
+	u64 west, east, attacks;
+	east     = east(target);
+	west     = west(target);
+	attacks  = (east|west) << 16;
+	attacks |= (east|west) >> 16;
+	east     = east(east);
+	west     = west(west);
+	attacks |= (east|west) <<  8;
+	attacks |= (east|west) >>  8;
+	return attacks;
+}
+
+static u64 king_attacks(int square)
+{
+	u64 target = square_bb(square);
+	u64 attacks = east(target) | west(target);
+	target     |= attacks;
+	attacks    |= north(target) | south(target);
+	return attacks;
+}
+
+static u64 pawn_attacks(int square, enum color color)
+{
+	u64 target = square_bb(square);
+	return (color == WHITE) ? north_east(target) | north_west(target)
+	                        : south_east(target) | south_west(target);
+}
+
+// squares strictly between a and b, or of the whole line through them, if
+// they share a rank, file or diagonal
+static u64 squares_between(int a, int b, bool whole_line)
+{
+	for (int bishop = 0; bishop < 2; ++bishop) {
+		if (a == b || !(slider_attacks(a, 0, bishop) & square_bb(b)))
+			continue;
+		if (whole_line)
+			return (slider_attacks(a, 0, bishop) & slider_attacks(b, 0, bishop))
+			     | square_bb(a) | square_bb(b);
+		return slider_attacks(a, square_bb(b), bishop)
+		     & slider_attacks(b, square_bb(a), bishop);
+	}
+	return 0;
+}
+
+static void print_square_pairs(const char *name, bool whole_line)
+{
+	printf("static const u64 %s[64][64] = {\n", name);
+	for (int a = 0; a < 64; ++a) {
+		printf("\t{");
+		for (int b = 0; b < 64; ++b) {
+			printf("%s0x%llxULL,", (b % 4) ? " " : "\n\t\t",
+			       squares_between(a, b, whole_line));
+		}
+		printf("\n\t},\n");
+	}
+	printf("};\n\n");
+}
+
+// software version of the PEXT instruction, packs the bits of bb selected by
+// mask into the low bits
+static u64 pext(u64 bb, u64 mask)
+{
+	u64 result = 0;
+	for (u64 bit = 1; mask; bit <<= 1) {
+		if (bb & mask & -mask)
+			result |= bit;
+		mask &= mask - 1;
+	}
+	return result;
+}
+
+static void print_table(const char *name, const u64 *table, int size)
+{
+	printf("static const u64 %s[%d] = {", name, size);
+	for (int i = 0; i < size; ++i)
+		printf("%s0x%llxULL,", (i % 4) ? " " : "\n\t", table[i]);
+	printf("\n};\n\n");
+}
+
+// Magic bitboards, the attack table index is the relevant blockers multiplied
+// by the magic number and shifted down to the number of relevant squares.
+static void print_magics(const char *name, const u64 *numbers, bool bishop)
+{
+	static u64 table[TABLE_SIZE];
+	static bool used[TABLE_SIZE];
+	u64 masks[64];
+	int offsets[64];
+	int size = 0;
+	memset(used, 0, sizeof(used));
+
+	for (int square = 0; square < 64; ++square) {
+		masks[square] = relevant_blockers(square, bishop);
+		offsets[square] = size;
+		int shift = 64 - __builtin_popcountll(masks[square]);
+
+		// every subset of the mask, colliding subsets must have the
+		// same attacks
+		u64 occupied = 0;
+		do {
+			int i = size + ((occupied * numbers[square]) >> shift);
+			u64 attacks = slider_attacks(square, occupied, bishop);
+			if (used[i] && table[i] != attacks) {
+				fprintf(stderr, "gentables: bad magic for square %d\n", square);
+				exit(1);
+			}
+			used[i] = true;
+			table[i] = attacks;
+			occupied = (occupied - masks[square]) & masks[square];
+		} while (occupied);
+		size += 1 << (64 - shift);
+	}
+
+	printf("#ifdef MAGIC_BITBOARDS\n");
+	char table_name[64];
+	snprintf(table_name, sizeof(table_name), "%s_table", name);
+	print_table(table_name, table, size);
+	printf("static const struct magic %s_magics[64] = {\n", name);
+	for (int square = 0; square < 64; ++square) {
+		printf("\t{ 0x%llxULL, 0x%llxULL, %s + %d, %d },\n",
+		       masks[square], numbers[square], table_name, offsets[square],
+		       64 - __builtin_popcountll(masks[square]));
+	}
+	printf("};\n#endif\n\n");
+}
+
+// PEXT bitboards, the attack table index is the relevant blockers packed into
+// the low bits.
+static void print_pexts(const char *name, bool bishop)
+{
+	static u64 table[TABLE_SIZE];
+	u64 masks[64];
+	int offsets[64];
+	int size = 0;
+
+	for (int square = 0; square < 64; ++square) {
+		masks[square] = relevant_blockers(square, bishop);
+		offsets[square] = size;
+
+		u64 occupied = 0;
+		do {
+			table[size + pext(occupied, masks[square])]
+				= slider_attacks(square, occupied, bishop);
+			occupied = (occupied - masks[square]) & masks[square];
+		} while (occupied);
+		size += 1 << __builtin_popcountll(masks[square]);
+	}
+
+	printf("#ifdef PEXT_BITBOARDS\n");
+	char table_name[64];
+	snprintf(table_name, sizeof(table_name), "%s_pext_table", name);
+	print_table(table_name, table, size);
+	printf("static const struct pext %s_pexts[64] = {\n", name);
+	for (int square = 0; square < 64; ++square) {
+		printf("\t{ 0x%llxULL, %s + %d },\n",
+		       masks[square], table_name, offsets[square]);
+	}
+	printf("};\n#endif\n\n");
+}
+
+// xorshift64*, the keys only need to be random looking and the same on every
+// build
+static u64 random_u64(void)
+{
+	static u64 state = 0x9e3779b97f4a7c15ULL;
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 0x2545f4914f6cdd1dULL;
+}
+
+// Keys of the pieces on every square, of every set of castling rights and of
+// the en passant square, 0 for SQUARES_NONE so it can be hashed regardless.
+static void print_zobrist(void)
+{
+	u64 table[64];
+
+	printf("// Generated by gentables.c, do not edit.\n\n");
+
+	printf("static const u64 zobrist_pieces[EMPTY][64] = {\n");
+	for (enum piece_id id = W_PAWN; id < EMPTY; ++id) {
+		printf("\t{");
+		for (int i = 0; i < 64; ++i)
+			printf("%s0x%llxULL,", (i % 4) ? " " : "\n\t\t", random_u64());
+		printf("\n\t},\n");
+	}
+	printf("};\n\n");
+
+	table[NO_CASTLING] = 0;
+	for (int i = 1; i <= ANY_CASTLING; ++i)
+		table[i] = random_u64();
+	print_table("zobrist_castling", table, ANY_CASTLING + 1);
+
+	for (int i = 0; i < 64; ++i)
+		table[i] = random_u64();
+	printf("static const u64 zobrist_ep[SQUARES_NONE + 1] = {");
+	for (int i = 0; i < 64; ++i)
+		printf("%s0x%llxULL,", (i % 4) ? " " : "\n\t", table[i]);
+	printf("\n\t0,\n};\n\n");
+
+	printf("static const u64 zobrist_side = 0x%llxULL;\n", random_u64());
+}
+
+static void print_movegen_tables(void)
+{
+	u64 table[4][64];
+
+	printf("// Generated by gentables.c, do not edit.\n\n");
+
+	// in the order of enum lineattacks
+	for (int i = 0; i < 64; ++i) {
+		table[0][i] = diagonal(i);
+		table[1][i] = antidiagonal(i);
+		table[2][i] = rank(i);
+		table[3][i] = file(i);
+	}
+	printf("static const u64 lineattacks[4][64] = {\n");
+	for (int type = 0; type < 4; ++type) {
+		printf("\t{");
+		for (int i = 0; i < 64; ++i)
+			printf("%s0x%llxULL,", (i % 4) ? " " : "\n\t\t", table[type][i]);
+		printf("\n\t},\n");
+	}
+	printf("};\n\n");
+
+	for (int i = 0; i < 64; ++i)
+		table[0][i] = knight_attacks(i);
+	print_table("knight_attacks", table[0], 64);
+
+	for (int i = 0; i < 64; ++i)
+		table[0][i] = king_attacks(i);
+	print_table("king_attacks", table[0], 64);
+
+	printf("static const u64 pawn_attacks[COLOR_MAX][64] = {\n");
+	for (enum color color = WHITE; color < COLOR_MAX; ++color) {
+		printf("\t{");
+		for (int i = 0; i < 64; ++i)
+			printf("%s0x%llxULL,", (i % 4) ? " " : "\n\t\t", pawn_attacks(i, color));
+		printf("\n\t},\n");
+	}
+	printf("};\n\n");
+
+	print_square_pairs("between_squares", false);
+	print_square_pairs("line_through", true);
+
+	print_magics("bishop", bishop_magic_numbers, true);
+	print_magics("rook", rook_magic_numbers, false);
+	print_pexts("bishop", true);
+	print_pexts("rook", false);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && strcmp(argv[1], "zobrist") == 0)
+		print_zobrist();
+	else
+		print_movegen_tables();
+	return 0;
+}
@@ -1,11 +1,13 @@
 #include "chess.h"
 #include "pgn.h"
 #include "pgn_ext.h"
+#include "pgn_index.h"
 
 #include "termbox2.h"
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define malloc_array(count, size) (malloc(count * size))
 
@@ -54,19 +56,14 @@ static char* piece_str[PIECE_ID_MAX] = {
 struct state {
 	struct pgn pgn;
 	struct board board;
+	struct history history;
 
 	move *moves;
 	int moves_idx;
-
-	// Stores captured pieces for unwinding
-	// 30 is the number of capturable pieces on a board
-	enum piece_id captures[30];
-	int captures_idx;
 };
 
 static struct state state = {
 	.moves_idx = -1,
-	.captures_idx = 0
 };
 
 void draw_square(int x, int y, char *str, uintattr_t fg, uintattr_t bg)
@@ -154,26 +151,19 @@ void do_move(bool undo)
 	move curr;
 	if (undo) {
 		curr = state.moves[state.moves_idx];
-		enum piece_id piece = EMPTY;
-		if (move_is_capture(curr)) {
-			--state.captures_idx;
-			piece = state.captures[state.captures_idx];
-		}
-		board_undo_move(&state.board, curr, piece);
 		--state.moves_idx;
+		if (state.history.count > 0) {
+			board_undo_move(&state.board, curr);
+		} else {
+			// the move is older than the history, replay up to it
+			board_init(&state.board);
+			board_set_history(&state.board, &state.history);
+			for (int i = 0; i <= state.moves_idx; ++i)
+				board_move(&state.board, state.moves[i]);
+		}
 	} else {
 		++state.moves_idx;
 		curr = state.moves[state.moves_idx];
-
-		if (move_is_capture(curr)) {
-			int from = move_from(curr);
-			enum color color = piece_color(state.board.squares[from]);
-			int sq = move_to(curr);
-			if (move_is_enpassant(curr))
-				sq += (color == WHITE) ? -8 : 8;
-			state.captures[state.captures_idx] = state.board.squares[sq];
-			++state.captures_idx;
-		}
 		board_move(&state.board, curr);
 	}
 
@@ -189,18 +179,46 @@ int main(int argc, char **argv)
 		return 1;
 	}
 	board_init(&state.board);
+	board_set_history(&state.board, &state.history);
+
+	// optional 1-based index of the game to view in a multi-game file
+	int game = (argc > 2) ? strtol(argv[2], NULL, 10) : 1;
+	if (game < 1) {
+		fprintf(stderr, "Invalid game number %s!\n", argv[2]);
+		return 1;
+	}
+
+	struct pgn_reader *reader = pgn_open(argv[1], 0);
+	if (reader == NULL) {
+		fprintf(stderr, "Could not open %s for reading!\n", argv[1]);
+		return 1;
+	}
 
 	// tags errors are fine, we are not doing anything with them
-	enum pgn_result pgn_res = pgn_read(&state.pgn, argv[1]);
-	if (pgn_res != PGN_OK) {
-		if (pgn_res == PGN_FILE_ERROR) {
-			fprintf(stderr, "Could not open %s for reading!\n", argv[1]);
-			return 1;
-		} else if (pgn_res == PGN_MOVE_PARSE_ERROR){
-			fprintf(stderr, "Errors while parsing moves, exiting!");
-			return 1;
+	enum pgn_result pgn_res;
+	struct pgn_index *index = (argc > 2) ? pgn_index_open(argv[1]) : NULL;
+	if (index) {
+		pgn_res = pgn_index_read(index, game - 1, reader, &state.pgn);
+		pgn_index_close(index);
+	} else {
+		// no index for pipes and such, skip to the game instead
+		for (int i = 1; i <= game; ++i) {
+			pgn_res = pgn_next_game(reader, &state.pgn);
+			if (pgn_res == PGN_EOF)
+				break;
 		}
 	}
+	pgn_close(reader);
+
+	if (pgn_res == PGN_EOF) {
+		fprintf(stderr, "%s has less than %d games!\n", argv[1], game);
+		return 1;
+	}
+
+	if (pgn_res == PGN_MOVE_PARSE_ERROR) {
+		fprintf(stderr, "Errors while parsing moves, exiting!");
+		return 1;
+	}
 
 	state.moves   = malloc_array(state.pgn.movecount, sizeof(move));
 	int moves_len = pgn_to_moves(&state.pgn, state.moves);
@@ -5,6 +5,12 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// x86-64 CPUs with BMI2 look up slider attacks with PEXT, whether the CPU has
+// it is checked at startup
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PEXT_BITBOARDS
+#endif
+
 #define ALL_SQUARES_BB (UINT64_MAX)
 
 enum lineattacks {
@@ -14,28 +20,33 @@ enum lineattacks {
 	VERTICAL,
 };
 
-// pre-initialized lineattacks table, used for bishops, rooks, and queens
-// indexed by lineattacks[diagonal|antidiagonal|horizontal|vertcal][square]
-// and gives the respective bitboard for each lineattack for the square
-static u64 lineattacks[4][64];
-static bool initialized = false;
-
-bool attacks_table_initilized()
-{
-	return initialized;
-}
+// Magic bitboards, the attacks for every blocker configuration of a square
+// are looked up by hashing the relevant blockers with a multiplication.
+struct magic {
+	u64 mask;		// relevant blockers, the rays without the board edge
+	u64 magic;
+	const u64 *attacks;	// table of 2^(64 - shift) attack sets
+	int shift;
+};
 
-void init_lineattacks_table()
-{
-	initialized = true;
-	for (int i = 0; i < 64; ++i) {
-		lineattacks[DIAGONAL][i]     = diagonal(i);
-		lineattacks[ANTIDIAGONAL][i] = antidiagonal(i);
-		lineattacks[HORIZONTAL][i]   = rank(i);
-		lineattacks[VERTICAL][i]     = file(i);
-	}
-}
+// PEXT bitboards, like magic bitboards but the relevant blockers are packed
+// into the index with a single instruction.
+struct pext {
+	u64 mask;		// relevant blockers
+	const u64 *attacks;	// table of 2^popcount(mask) attack sets
+};
 
+// All attack tables are generated at build time by gentables.c:
+//
+// lineattacks[diagonal|antidiagonal|horizontal|vertcal][square] gives the
+// respective line through the square, used for the classical slider attacks.
+// knight_attacks, king_attacks and pawn_attacks[color] give the attacks of the
+// piece on a square. between_squares[a][b] and line_through[a][b] give the
+// squares between a and b and the whole line through them, if they are on a
+// common line. The magic and PEXT tables are only there when used.
+#include "movegen_tables.h"
+
+#ifndef MAGIC_BITBOARDS
 // classical method to determine squares for queens, rooks, and bishops
 static u64 pos_ray_attacks(int square, u64 occupied, enum lineattacks type)
 {
@@ -50,32 +61,40 @@ static u64 neg_ray_attacks(int square, u64 occupied, enum lineattacks type)
 	u64 blocker = msb((attacks & occupied) | 1);
 	return attacks ^ neg_ray(lineattacks[type][blocker], blocker);
 }
+#endif
+
+static inline u64 knight_attacks_bb(int square)
+{
+	return knight_attacks[square];
+}
+
+static inline u64 king_attacks_bb(int square)
+{
+	return king_attacks[square];
+}
+
+static inline u64 pawn_attacks_bb(int square, enum color color)
+{
+	return pawn_attacks[color][square];
+}
 
-static u64 knight_attacks_bb(int square)
+#ifdef MAGIC_BITBOARDS
+static inline u64 magic_attacks(const struct magic *m, u64 occupied)
 {
-	u64 target = square_bb(square);
-	u64 west, east, attacks;
-	east     = east(target);
-	west     = west(target);
-	attacks  = (east|west) << 16;
-	attacks |= (east|west) >> 16;
-	east     = east(east);
-	west     = west(west);
-	attacks |= (east|west) <<  8;
-	attacks |= (east|west) >>  8;
-	return attacks;
+	return m->attacks[((occupied & m->mask) * m->magic) >> m->shift];
 }
 
-static u64 king_attacks_bb(int square)
+u64 portable_bishop_attacks(int square, u64 occupied)
 {
-	u64 target = square_bb(square);
-	u64 attacks = east(target) | west(target);
-	target     |= attacks;
-	attacks    |= north(target) | south(target);
-	return attacks;
+	return magic_attacks(&bishop_magics[square], occupied);
 }
 
-static u64 bishop_attacks_bb(int square, u64 occupied)
+u64 portable_rook_attacks(int square, u64 occupied)
+{
+	return magic_attacks(&rook_magics[square], occupied);
+}
+#else
+u64 portable_bishop_attacks(int square, u64 occupied)
 {
 	return pos_ray_attacks(square, occupied, DIAGONAL)
 	     | neg_ray_attacks(square, occupied, DIAGONAL)
@@ -83,13 +102,58 @@ static u64 bishop_attacks_bb(int square, u64 occupied)
 	     | neg_ray_attacks(square, occupied, ANTIDIAGONAL);
 }
 
-static u64 rook_attacks_bb(int square, u64 occupied)
+u64 portable_rook_attacks(int square, u64 occupied)
 {
 	return pos_ray_attacks(square, occupied, HORIZONTAL)
 	     | neg_ray_attacks(square, occupied, HORIZONTAL)
 	     | pos_ray_attacks(square, occupied, VERTICAL)
 	     | neg_ray_attacks(square, occupied, VERTICAL);
 }
+#endif
+
+#ifdef PEXT_BITBOARDS
+// set before main() runs, so it is never written once threads exist
+static bool use_pext;
+
+__attribute__((constructor))
+static void detect_pext(void)
+{
+	__builtin_cpu_init();
+	use_pext = __builtin_cpu_supports("bmi2");
+}
+
+// the instruction is emitted directly, so lookups are inlined into code
+// compiled without BMI2, which must then only run them on CPUs having it
+static inline u64 pext(u64 bb, u64 mask)
+{
+	u64 result;
+	__asm__ ("pextq %2, %1, %0" : "=r" (result) : "r" (bb), "rm" (mask));
+	return result;
+}
+
+static inline u64 pext_attacks(const struct pext *p, u64 occupied)
+{
+	return p->attacks[pext(occupied, p->mask)];
+}
+#endif
+
+static inline u64 bishop_attacks_bb(int square, u64 occupied)
+{
+#ifdef PEXT_BITBOARDS
+	if (use_pext)
+		return pext_attacks(&bishop_pexts[square], occupied);
+#endif
+	return portable_bishop_attacks(square, occupied);
+}
+
+static inline u64 rook_attacks_bb(int square, u64 occupied)
+{
+#ifdef PEXT_BITBOARDS
+	if (use_pext)
+		return pext_attacks(&rook_pexts[square], occupied);
+#endif
+	return portable_rook_attacks(square, occupied);
+}
 
 static u64 queen_attacks_bb(int square, u64 occupied)
 {
@@ -97,6 +161,16 @@ static u64 queen_attacks_bb(int square, u64 occupied)
 	     | rook_attacks_bb(square, occupied);
 }
 
+u64 bishop_attacks(int square, u64 occupied)
+{
+	return bishop_attacks_bb(square, occupied);
+}
+
+u64 rook_attacks(int square, u64 occupied)
+{
+	return rook_attacks_bb(square, occupied);
+}
+
 static u64 attacks_bb(int square, u64 occupied, enum piece piece)
 {
 	assert(piece != PAWN && piece != ALL);
@@ -111,6 +185,61 @@ static u64 attacks_bb(int square, u64 occupied, enum piece piece)
 	return 0ULL;
 }
 
+// The attackers of a square are found from the square itself, a piece on it
+// attacks the same squares as are attacked from them, except for pawns which
+// attack the other way. Every piece type is tested and the results combined
+// without branching.
+static inline u64 attackers_to_bb(const struct board *board, int square, u64 occupied)
+{
+	u64 queens = board->pieces[QUEEN];
+	return (pawn_attacks_bb(square, WHITE) & pawns(board, BLACK))
+	     | (pawn_attacks_bb(square, BLACK) & pawns(board, WHITE))
+	     | (knight_attacks_bb(square) & board->pieces[KNIGHT])
+	     | (king_attacks_bb(square) & board->pieces[KING])
+	     | (bishop_attacks_bb(square, occupied) & (board->pieces[BISHOP] | queens))
+	     | (rook_attacks_bb(square, occupied) & (board->pieces[ROOK] | queens));
+}
+
+static inline bool is_attacked_bb(const struct board *board, int square, u64 occupied,
+                                  enum color by_color)
+{
+	u64 queens = board->pieces[QUEEN];
+	u64 attackers = (pawn_attacks_bb(square, flip_color(by_color)) & board->pieces[PAWN])
+	              | (knight_attacks_bb(square) & board->pieces[KNIGHT])
+	              | (king_attacks_bb(square) & board->pieces[KING])
+	              | (bishop_attacks_bb(square, occupied) & (board->pieces[BISHOP] | queens))
+	              | (rook_attacks_bb(square, occupied) & (board->pieces[ROOK] | queens));
+	return (attackers & board->colors[by_color]) != 0;
+}
+
+u64 attackers_to(const struct board *board, int square, u64 occupied)
+{
+	return attackers_to_bb(board, square, occupied);
+}
+
+bool is_attacked(const struct board *board, int square, enum color by_color)
+{
+	return is_attacked_bb(board, square, board->pieces[ALL], by_color);
+}
+
+// pieces of color which are the only piece between their king and an enemy
+// slider, these may only move along the line of the pin
+static u64 pinned_pieces(const struct board *board, int king, enum color color)
+{
+	enum color them = flip_color(color);
+	u64 queens  = pieces(board, QUEEN, them);
+	u64 snipers = (bishop_attacks_bb(king, 0) & (pieces(board, BISHOP, them) | queens))
+	            | (rook_attacks_bb(king, 0) & (pieces(board, ROOK, them) | queens));
+
+	u64 pinned = 0;
+	while (snipers) {
+		u64 blockers = between_squares[king][pop_lsb(&snipers)] & board->pieces[ALL];
+		if (blockers && !(blockers & (blockers - 1)))
+			pinned |= blockers;
+	}
+	return pinned & board->colors[color];
+}
+
 static move* all_promotions(move *moves, int from, int to, bool is_capture)
 {
 	for (int i = 0; i < 4; ++i)
@@ -118,12 +247,32 @@ static move* all_promotions(move *moves, int from, int to, bool is_capture)
 	return moves;
 }
 
-static move* generate_pawn_moves(struct board *board, move *moves, struct movegenc *conf)
-{
-	enum gentype movetype = conf->type;
-	enum color color = conf->color;
-	u64 target = conf->target;
+// Pawn shifts towards the side of color. The pawn and castling generators are
+// written once for both colors but only ever called with a constant color, so
+// once inlined every test on it folds away.
+#define pawn_up(b, color)       ((color) == WHITE ? north((b))      : south((b)))
+#define pawn_up_right(b, color) ((color) == WHITE ? north_east((b)) : south_west((b)))
+#define pawn_up_left(b, color)  ((color) == WHITE ? north_west((b)) : south_east((b)))
+
+// inline is only a hint, which gcc at -O2 ignores for the larger generators
+#if   defined(__GNUC__)
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define ALWAYS_INLINE __forceinline
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+// kinds of legal moves to generate, captures and promotions are noisy
+enum legal_moves {
+	NOISY_MOVES = 1,
+	QUIET_MOVES = 2,
+	LEGAL_MOVES = NOISY_MOVES | QUIET_MOVES
+};
 
+static ALWAYS_INLINE move* pawn_moves(const struct board *board, move *moves, enum gentype movetype,
+                                      u64 target, enum color color)
+{
 	u64 empty   = ~board->pieces[ALL] & target;
 	u64 enemies =  board->colors[flip_color(color)] & target;
 
@@ -141,8 +290,10 @@ static move* generate_pawn_moves(struct board *board, move *moves, struct movege
 	u64 rank2_pawns = pawns(board, color) & rank2;
 
 	if (movetype == QUIET) {
-		u64 b1 = shift(not_rank7_pawns, up) & empty;
-		u64 b2 = shift(shift(rank2_pawns, up), up) & empty;
+		u64 b1 = pawn_up(not_rank7_pawns, color) & empty;
+		// the square in between must be empty, whatever the target
+		u64 b2 = pawn_up(rank2_pawns, color) & ~board->pieces[ALL];
+		b2 = pawn_up(b2, color) & empty;
 		
 		while (b1) {
 			int to = pop_lsb(&b1);
@@ -153,8 +304,8 @@ static move* generate_pawn_moves(struct board *board, move *moves, struct movege
 			*moves++ = make_quiet(to - up - up, to);
 		}
 	} else if (movetype == PROMO_CAPTURE) {
-		u64 b1 = shift(rank7_pawns, up_right) & enemies;
-		u64 b2 = shift(rank7_pawns, up_left) & enemies;
+		u64 b1 = pawn_up_right(rank7_pawns, color) & enemies;
+		u64 b2 = pawn_up_left(rank7_pawns, color) & enemies;
 
 		while (b1) {
 			int to = pop_lsb(&b1);
@@ -166,15 +317,15 @@ static move* generate_pawn_moves(struct board *board, move *moves, struct movege
 			moves = all_promotions(moves, to - up_left, to, true);
 		}
 	} else if (movetype == PROMOTION) {
-		u64 b1 = shift(rank7_pawns, up) & empty;
+		u64 b1 = pawn_up(rank7_pawns, color) & empty;
 
 		while (b1) {
 			int to = pop_lsb(&b1);
 			moves = all_promotions(moves, to - up, to, false);
 		}
 	} else if (movetype == CAPTURE) {
-		u64 b1 = shift(not_rank7_pawns, up_right) & enemies;
-		u64 b2 = shift(not_rank7_pawns, up_left) & enemies;
+		u64 b1 = pawn_up_right(not_rank7_pawns, color) & enemies;
+		u64 b2 = pawn_up_left(not_rank7_pawns, color) & enemies;
 
 		while (b1) {
 			int to = pop_lsb(&b1);
@@ -185,52 +336,238 @@ static move* generate_pawn_moves(struct board *board, move *moves, struct movege
 			*moves++ = make_capture(to - up_left, to);
 		}
 
-		if (board->ep_square != SQUARES_NONE) {
-			b1 = shift(not_rank7_pawns, up_right) & square_bb(board->ep_square);
-			b2 = shift(not_rank7_pawns, up_left) & square_bb(board->ep_square);
+		// the pawns attacking the en passant square are on the squares a
+		// pawn of the other color on it would attack
+		if (board->ep_square != SQUARES_NONE && (target & square_bb(board->ep_square))) {
+			b1 = pawn_attacks_bb(board->ep_square, flip_color(color)) & not_rank7_pawns;
 
 			while (b1) {
-				int to = pop_lsb(&b1);
-				*moves++ = make_enpassant(to - up_right, board->ep_square);
-			}
-			while (b2) {
-				int to = pop_lsb(&b2);
-				*moves++ = make_enpassant(to - up_left, board->ep_square);
+				int from = pop_lsb(&b1);
+				*moves++ = make_enpassant(from, board->ep_square);
 			}
 		}
 	}
 	return moves;
 }
 
-static u64 h_ray(int square, u64 occupied, bool is_negative)
+// the pawn moves of color to target which are of the kinds in which
+static ALWAYS_INLINE move* all_pawn_moves(const struct board *board, move *moves, u64 target,
+                                          enum legal_moves which, enum color color)
+{
+	if (which & QUIET_MOVES)
+		moves = pawn_moves(board, moves, QUIET, target, color);
+	if (which & NOISY_MOVES) {
+		moves = pawn_moves(board, moves, CAPTURE, target, color);
+		moves = pawn_moves(board, moves, PROMOTION, target, color);
+		moves = pawn_moves(board, moves, PROMO_CAPTURE, target, color);
+	}
+	return moves;
+}
+
+static move* generate_pawn_moves(const struct board *board, move *moves, struct movegenc *conf)
+{
+	if (conf->color == WHITE)
+		return pawn_moves(board, moves, conf->type, conf->target, WHITE);
+	return pawn_moves(board, moves, conf->type, conf->target, BLACK);
+}
+
+// Castling moves are encoded as the king capturing its own rook, which must be
+// in target. The king may not castle out of, through or into check.
+static ALWAYS_INLINE move* castle_moves(const struct board *board, move *moves, u64 target,
+                                        enum color color)
+{
+	int king = (color == WHITE) ? e1 : e8;
+	enum color them = flip_color(color);
+
+	for (int queenside = 0; queenside < 2; ++queenside) {
+		int rook = (queenside) ? king - 4 : king + 3;
+		int step = (queenside) ? -1 : 1;
+
+		if (!can_castle(board, color, queenside)
+		 || !(target & square_bb(rook))
+		 || (between_squares[king][rook] & board->pieces[ALL]))
+			continue;
+
+		bool attacked = false;
+		for (int i = 0; i <= 2; ++i)
+			attacked |= is_attacked_bb(board, king + i * step, board->pieces[ALL], them);
+		if (!attacked)
+			*moves++ = make_castle(king, rook);
+	}
+	return moves;
+}
+
+static move* generate_castle_moves(const struct board *board, move *moves, u64 target,
+                                   enum color color)
+{
+	if (color == WHITE)
+		return castle_moves(board, moves, target, WHITE);
+	return castle_moves(board, moves, target, BLACK);
+}
+
+// en passant removes two pawns from the rank of the capture, possibly
+// uncovering an attack on the king, which pins alone do not catch
+static bool enpassant_is_legal(const struct board *board, move move, int king, enum color color)
+{
+	enum color them = flip_color(color);
+	int from = move_from(move);
+	int to   = move_to(move);
+	int captured = to + ((color == WHITE) ? -8 : 8);
+	u64 occupied = (board->pieces[ALL] ^ square_bb(from) ^ square_bb(captured)) | square_bb(to);
+
+	u64 queens = pieces(board, QUEEN, them);
+	return !(bishop_attacks_bb(king, occupied) & (pieces(board, BISHOP, them) | queens))
+	    && !(rook_attacks_bb(king, occupied) & (pieces(board, ROOK, them) | queens));
+}
+
+// drops the pawn moves in [first, last) which leave the king in check
+static move* filter_pawn_moves(const struct board *board, move *first, move *last,
+                               int king, u64 pinned, enum color color)
+{
+	move *out = first;
+	for (move *m = first; m < last; ++m) {
+		int from = move_from(*m);
+		int to   = move_to(*m);
+		if (move_is_enpassant(*m)) {
+			if (enpassant_is_legal(board, *m, king, color))
+				*out++ = *m;
+		} else if (!(pinned & square_bb(from)) || (line_through[king][from] & square_bb(to))) {
+			*out++ = *m;
+		}
+	}
+	return out;
+}
+
+static move* generate_legal_pawn_moves(const struct board *board, move *moves, enum color color,
+                                       u64 target, u64 pinned, int king,
+                                       enum legal_moves which)
+{
+	move *first = moves;
+	if (color == WHITE)
+		moves = all_pawn_moves(board, moves, target, which, WHITE);
+	else
+		moves = all_pawn_moves(board, moves, target, which, BLACK);
+
+	if ((pinned & pawns(board, color)) || board->ep_square != SQUARES_NONE)
+		moves = filter_pawn_moves(board, first, moves, king, pinned, color);
+	return moves;
+}
+
+// moves of the pieces in movers, a pinned piece only along the line of its pin
+static move* generate_piece_moves(const struct board *board, move *moves, enum piece piece,
+                                  u64 movers, u64 target, u64 pinned, int king)
+{
+	u64 occupied = board->pieces[ALL];
+	u64 enemies  = board->colors[flip_color(piece_color(board->squares[king]))];
+	target &= ~(occupied & ~enemies);
+
+	while (movers) {
+		int from = pop_lsb(&movers);
+		u64 bb   = attacks_bb(from, occupied, piece) & target;
+		if (pinned & square_bb(from))
+			bb &= line_through[king][from];
+
+		u64 captures = bb & enemies;
+		u64 quiets   = bb & ~enemies;
+		while (captures)
+			*moves++ = make_capture(from, pop_lsb(&captures));
+		while (quiets)
+			*moves++ = make_quiet(from, pop_lsb(&quiets));
+	}
+	return moves;
+}
+
+// the king must not be left attacked through the square it leaves
+static move* generate_king_moves(const struct board *board, move *moves, enum color color,
+                                 int king, u64 target)
 {
-	return (is_negative) ? neg_ray_attacks(square, occupied, HORIZONTAL)
-	                     : pos_ray_attacks(square, occupied, HORIZONTAL);
+	u64 enemies  = board->colors[flip_color(color)];
+	u64 occupied = board->pieces[ALL] ^ square_bb(king);
+
+	u64 bb = king_attacks_bb(king) & ~board->colors[color] & target;
+	while (bb) {
+		int to = pop_lsb(&bb);
+		if (!is_attacked_bb(board, to, occupied, flip_color(color)))
+			*moves++ = make_move(king, to, (enemies & square_bb(to)) != 0, false, 0);
+	}
+	return moves;
 }
 
-// TODO: check for attacks on squares between rook and king
-static move* generate_castle_moves(struct board *board, move *moves, struct movegenc *conf)
+// In check the only legal moves are king moves off the attacked squares and,
+// unless in double check, captures of the checker and blocks of its ray by
+// pieces which are not pinned, since a pinned piece can never do either.
+// Generates these for piece, or every piece if it is ALL.
+static move* generate_evasions(const struct board *board, move *moves, enum color color,
+                               enum piece piece, u64 checkers)
 {
-	u64 king = (conf->color == WHITE) ? e1 : e8;
-	for (int i = 0; i < 2; ++i) {
-		if (can_castle(board, conf->color, i)) {
-			u64 bb = h_ray(king, board->pieces[ALL], i) & conf->target;
-			if (bb)
-				*moves++ = make_castle(king, pop_lsb(&bb));
+	int king = lsb(pieces(board, KING, color));
+	if (piece == KING || piece == ALL)
+		moves = generate_king_moves(board, moves, color, king, ALL_SQUARES_BB);
+
+	if ((checkers & (checkers - 1)) || piece == KING)
+		return moves;
+
+	u64 pinned = pinned_pieces(board, king, color);
+	u64 target = checkers | between_squares[king][lsb(checkers)];
+
+	if (piece == PAWN || piece == ALL) {
+		// en passant captures a checking pawn from behind, no other
+		// pawn move can reach the square behind a pawn
+		u64 pawn_target = target;
+		int pushed = board->ep_square + ((color == WHITE) ? -8 : 8);
+		if (board->ep_square != SQUARES_NONE && (checkers & square_bb(pushed)))
+			pawn_target |= square_bb(board->ep_square);
+		moves = generate_legal_pawn_moves(board, moves, color, pawn_target, pinned, king,
+		                                  LEGAL_MOVES);
+	}
+
+	for (enum piece p = KNIGHT; p <= QUEEN; ++p) {
+		if (piece == p || piece == ALL) {
+			u64 movers = pieces(board, p, color) & ~pinned;
+			moves = generate_piece_moves(board, moves, p, movers, target, 0, king);
 		}
 	}
 	return moves;
 }
 
-move* generate_moves(struct board *board, move *moves, struct movegenc *conf)
+static enum gentype move_gentype(move move)
 {
-	assert(initialized == true);
+	if (move_is_castle(move))
+		return CASTLE;
+	if (move_is_promotion(move))
+		return move_is_capture(move) ? PROMO_CAPTURE : PROMOTION;
+	return move_is_capture(move) ? CAPTURE : QUIET;
+}
+
+// pieces of the other color giving check to the king of color
+static u64 checkers_of(const struct board *board, enum color color)
+{
+	u64 king = pieces(board, KING, color);
+	if (!king)
+		return 0;
+	return attackers_to_bb(board, lsb(king), board->pieces[ALL])
+	     & board->colors[flip_color(color)];
+}
+
+move* generate_moves(const struct board *board, move *moves, struct movegenc *conf)
+{
+	// in check only evasions can be legal, so only those of the requested
+	// type and target are kept
+	u64 checkers = checkers_of(board, conf->color);
+	if (checkers) {
+		move *last = generate_evasions(board, moves, conf->color, conf->piece, checkers);
+		for (move *m = moves; m < last; ++m) {
+			if (move_gentype(*m) == conf->type && (conf->target & square_bb(move_to(*m))))
+				*moves++ = *m;
+		}
+		return moves;
+	}
 
 	if (conf->piece == PAWN)
 		return generate_pawn_moves(board, moves, conf);
 
 	if (conf->type == CASTLE)
-		return generate_castle_moves(board, moves, conf);
+		return generate_castle_moves(board, moves, conf->target, conf->color);
 
 	assert(conf->type != PROMOTION && conf->type != PROMO_CAPTURE);
 
@@ -252,42 +589,213 @@ move* generate_moves(struct board *board, move *moves, struct movegenc *conf)
 	return moves;
 }
 
-static move*
-generate_quiet_and_captures(struct board *board, move *moves, struct movegenc *conf)
+// The legal moves of which kind when not in check. A pinned piece may only
+// move along the line of its pin, only the king's moves and en passant are
+// tested individually.
+static move* generate_unchecked_moves(const struct board *board, move *moves, enum color color,
+                                      int king, u64 pinned, enum legal_moves which)
 {
-	conf->type = CAPTURE;
-	moves = generate_moves(board, moves, conf);
-	conf->type = QUIET;
-	moves = generate_moves(board, moves, conf);
+	u64 target = 0;
+	if (which & NOISY_MOVES)
+		target |= board->colors[flip_color(color)];
+	if (which & QUIET_MOVES)
+		target |= ~board->pieces[ALL];
+
+	moves = generate_king_moves(board, moves, color, king, target);
+	moves = generate_legal_pawn_moves(board, moves, color, ALL_SQUARES_BB, pinned, king,
+	                                  which);
+	for (enum piece piece = KNIGHT; piece <= QUEEN; ++piece) {
+		moves = generate_piece_moves(board, moves, piece, pieces(board, piece, color),
+		                             target, pinned, king);
+	}
 
+	if (which & QUIET_MOVES)
+		moves = generate_castle_moves(board, moves, ALL_SQUARES_BB, color);
 	return moves;
 }
 
-move* generate_legal_moves(struct board *board, move *moves, enum color color)
-{
-	struct movegenc conf = {
-		.color = color,
-		.target = ALL_SQUARES_BB,
-	};
-
-	conf.piece = PAWN;
-	conf.type = QUIET;
-	moves = generate_pawn_moves(board, moves, &conf);
-	conf.type = CAPTURE;
-	moves = generate_pawn_moves(board, moves, &conf);
-	conf.type = PROMOTION;
-	moves = generate_pawn_moves(board, moves, &conf);
-	conf.type = PROMO_CAPTURE;
-	moves = generate_pawn_moves(board, moves, &conf);
-
-	conf.piece = KNIGHT;
-	moves = generate_quiet_and_captures(board, moves, &conf);
-	conf.piece = BISHOP;
-	moves = generate_quiet_and_captures(board, moves, &conf);
-	conf.piece = ROOK;
-	moves = generate_quiet_and_captures(board, moves, &conf);
-	conf.piece = QUEEN;
-	moves = generate_quiet_and_captures(board, moves, &conf);
+// The checkers and the pinned pieces are found once, then the targets of every
+// piece are restricted so that it only makes legal moves. In check that is
+// left to generate_evasions().
+move* generate_legal_moves(const struct board *board, move *moves, enum color color)
+{
+	u64 checkers = checkers_of(board, color);
+	if (checkers)
+		return generate_evasions(board, moves, color, ALL, checkers);
 
-	return moves;
+	int king = lsb(pieces(board, KING, color));
+	return generate_unchecked_moves(board, moves, color, king,
+	                                pinned_pieces(board, king, color), LEGAL_MOVES);
+}
+
+// Pawn moves of color to target, counted a whole set of pawns at a time from the
+// pawns which may push and those which may capture in any direction. En
+// passant is left to the caller.
+static inline int count_pawn_moves(const struct board *board, u64 pushers, u64 capturers,
+                                   u64 target, enum color color)
+{
+	u64 empty   = ~board->pieces[ALL];
+	u64 enemies = board->colors[flip_color(color)];
+	u64 rank2   = (color == WHITE) ? rank_2 : rank_7;
+	u64 rank8   = (color == WHITE) ? rank_8 : rank_1;
+
+	u64 single = pawn_up(pushers, color) & empty;
+	u64 twice  = pawn_up(single & pawn_up(rank2, color), color) & empty & target;
+	u64 right  = pawn_up_right(capturers, color) & enemies & target;
+	u64 left   = pawn_up_left(capturers, color) & enemies & target;
+	single &= target;
+
+	// promotions count once for every piece
+	return popcount(single & ~rank8) + popcount(twice)
+	     + popcount(right & ~rank8) + popcount(left & ~rank8)
+	     + 4 * (popcount(single & rank8) + popcount(right & rank8) + popcount(left & rank8));
+}
+
+// In check pinned pawns can neither capture the checker nor block, elsewise a
+// pawn pinned along its file can still push and one pinned along a diagonal
+// can still capture on it. En passant can uncover an attack on the king in
+// more ways than pins and is tested move by move.
+static int count_legal_pawn_moves(const struct board *board, enum color color, u64 target,
+                                  u64 pinned, int king, bool in_check)
+{
+	u64 pawns = pawns(board, color);
+	u64 free  = pawns & ~pinned;
+	u64 file_pinned = (in_check) ? 0 : pawns & pinned & file(king);
+	u64 diag_pinned = (in_check) ? 0 : pawns & pinned & ~file(king) & ~rank(king);
+
+	int count = 0;
+	if (color == WHITE)
+		count += count_pawn_moves(board, free | file_pinned, free, target, WHITE);
+	else
+		count += count_pawn_moves(board, free | file_pinned, free, target, BLACK);
+
+	while (diag_pinned) {
+		int from = pop_lsb(&diag_pinned);
+		u64 bb = pawn_attacks_bb(from, color) & line_through[king][from]
+		       & board->colors[flip_color(color)] & target;
+		count += popcount(bb & ~(rank_1 | rank_8)) + 4 * popcount(bb & (rank_1 | rank_8));
+	}
+
+	int ep = board->ep_square;
+	if (ep != SQUARES_NONE && (target & square_bb(ep))) {
+		u64 bb = pawn_attacks_bb(ep, flip_color(color)) & pawns;
+		while (bb) {
+			int from = pop_lsb(&bb);
+			count += enpassant_is_legal(board, make_enpassant(from, ep), king, color);
+		}
+	}
+	return count;
+}
+
+// Counts the moves generate_legal_moves() would generate, from the same check
+// and pin restricted targets. Only king moves, en passant and castling are
+// tested one by one.
+int count_legal_moves(const struct board *board)
+{
+	enum color color = board->side;
+	int king = lsb(pieces(board, KING, color));
+	u64 checkers = checkers_of(board, color);
+	u64 own = board->colors[color];
+
+	int count = 0;
+	u64 occupied = board->pieces[ALL] ^ square_bb(king);
+	u64 bb = king_attacks_bb(king) & ~own;
+	while (bb)
+		count += !is_attacked_bb(board, pop_lsb(&bb), occupied, flip_color(color));
+
+	if (checkers & (checkers - 1))
+		return count;
+
+	u64 pinned = pinned_pieces(board, king, color);
+	u64 target = ALL_SQUARES_BB;
+	u64 pawn_target = ALL_SQUARES_BB;
+	if (checkers) {
+		target = checkers | between_squares[king][lsb(checkers)];
+		// en passant captures a checking pawn from behind
+		pawn_target = target;
+		int pushed = board->ep_square + ((color == WHITE) ? -8 : 8);
+		if (board->ep_square != SQUARES_NONE && (checkers & square_bb(pushed)))
+			pawn_target |= square_bb(board->ep_square);
+	}
+	count += count_legal_pawn_moves(board, color, pawn_target, pinned, king, checkers != 0);
+
+	for (enum piece piece = KNIGHT; piece <= QUEEN; ++piece) {
+		u64 movers = pieces(board, piece, color);
+		while (movers) {
+			int from = pop_lsb(&movers);
+			u64 attacks = attacks_bb(from, board->pieces[ALL], piece) & ~own & target;
+			if (pinned & square_bb(from))
+				attacks &= (checkers) ? 0 : line_through[king][from];
+			count += popcount(attacks);
+		}
+	}
+
+	if (!checkers) {
+		move castles[2];
+		count += generate_castle_moves(board, castles, ALL_SQUARES_BB, color) - castles;
+	}
+	return count;
+}
+
+void movepicker_init(struct movepicker *picker, const struct board *board, enum color color)
+{
+	picker->board = board;
+	picker->color = color;
+	picker->stage = PICK_START;
+	picker->next  = picker->last = picker->moves;
+}
+
+// moves the noisy moves in [first, last) ahead of the quiet ones
+static void partition_noisy(move *first, move *last)
+{
+	for (move *m = first; m < last; ++m) {
+		if (!move_is_quiet(*m)) {
+			move noisy = *m;
+			*m = *first;
+			*first++ = noisy;
+		}
+	}
+}
+
+// Finding the checkers and pins is left to the first move asked for. In check
+// all evasions are generated at once, there are few of them.
+move movepicker_next(struct movepicker *picker)
+{
+	while (picker->next == picker->last) {
+		const struct board *board = picker->board;
+		enum color color = picker->color;
+		move *moves = picker->moves;
+
+		switch (picker->stage) {
+		case PICK_START:
+			picker->stage = PICK_NOISY;
+			picker->king  = lsb(pieces(board, KING, color));
+			picker->checkers = checkers_of(board, color);
+			if (picker->checkers) {
+				picker->last = generate_evasions(board, moves, color, ALL,
+				                                 picker->checkers);
+				partition_noisy(moves, picker->last);
+			} else {
+				picker->pinned = pinned_pieces(board, picker->king, color);
+				picker->last = generate_unchecked_moves(board, moves, color,
+				                                        picker->king, picker->pinned,
+				                                        NOISY_MOVES);
+			}
+			break;
+		case PICK_NOISY:
+			// the evasions were all noisy and quiet moves together
+			picker->stage = PICK_QUIET;
+			picker->last  = (picker->checkers) ? moves
+			              : generate_unchecked_moves(board, moves, color, picker->king,
+			                                         picker->pinned, QUIET_MOVES);
+			break;
+		case PICK_QUIET:
+			picker->stage = PICK_DONE;
+			// fall through
+		case PICK_DONE:
+			return 0;
+		}
+		picker->next = moves;
+	}
+	return *picker->next++;
 }
@@ -0,0 +1,35 @@
+#include "chess.h"
+
+// Leaves are counted with count_legal_moves() rather than made, the moves
+// above them are made on copies of the board, so the board given is never
+// changed.
+u64 perft(const struct board *board, int depth)
+{
+	if (depth <= 0)
+		return 1;
+	if (depth == 1)
+		return count_legal_moves(board);
+
+	move moves[MAX_MOVES];
+	move *last = generate_legal_moves(board, moves, board->side);
+
+	u64 nodes = 0;
+	for (move *m = moves; m < last; ++m) {
+		struct board child;
+		board_make_copy(&child, board, *m);
+		nodes += perft(&child, depth - 1);
+	}
+	return nodes;
+}
+
+int perft_divide(const struct board *board, int depth, move *moves, u64 *nodes)
+{
+	int count = generate_legal_moves(board, moves, board->side) - moves;
+
+	for (int i = 0; i < count; ++i) {
+		struct board child;
+		board_make_copy(&child, board, moves[i]);
+		nodes[i] = (depth > 0) ? perft(&child, depth - 1) : 0;
+	}
+	return count;
+}
@@ -1,11 +1,19 @@
 #include "pgn.h"
+#include "pgn_internal.h"
 
-#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // pgn standard:
 // https://ia802908.us.archive.org/26/items/pgn-standard-1994-03-12/PGN_standard_1994-03-12.txt
@@ -47,35 +55,130 @@ static const char* token_str[TK_MAX] = {
 
 static const char *syntax_err =
 	"Error(Syntax) |%d, col %d|: expected token '%s' "
-	"but found token '%s' with value '%s'\n";
+	"but found token '%s' with value '%.*s'\n";
 
 static const char *parser_err =
 	"Error(Parser) |%d, col %d|: error occured trying to parse '%s'\n";
 
+// symbols and strings longer than this are truncated
+#define TOKEN_MAX 255
+
+// size of the read buffer for inputs which cannot be mapped
+#define READ_SIZE (64 * 1024)
+
 struct token {
 	enum token_type type; // type of the token
-	char value[256];      // symbols and strings have max length of 255
-	int len;              // length of value, including the null terminator
+	const char *value;    // slice of the input, not null terminated
+	int len;              // length of value
+	long long pos;        // offset of the token in the input
 };
 
 // internal structure for sharing data between parsing functions
 struct parser {
 	enum pgn_result result;
-	// lexer
-	FILE *file;
+	// lexer, tokens are slices of the input which is either a mapping of
+	// the whole file or, for pipes and such, a buffer refilled from fd
+	int fd;
+	char *map;
+	size_t mapsize;
+	char *buf;
+	const char *cur, *end;	// unread input
+	const char *mark;	// start of the token being lexed, if any
+	const char *origin;	// origin is at offset base of the input
+	long long base;
 	struct token token;
-	char last_char;
 	int y, x;	// location of lexer cursor (syntax errors)
 
 	// parser
+	int flags;	// enum pgn_flags
 	bool unhandled_error;
 	int py, px;	// location of parser cursor (parser errors)
+	int plies;	// moves of the current game so far
+	pgn_move_handler on_move;	// takes moves instead of the game
+	void *on_move_data;
 
 	// data
 	struct pgn *pgn;
 };
 
-// stretchy buffer from skeeto's growable-buf
+// the lexer state is kept between games, so the reader only ever holds the
+// game currently being parsed
+struct pgn_reader {
+	struct parser parser;
+};
+
+// Arena backing all strings and arrays of a game, blocks are only released
+// by pgn_free(). Resetting a chain of blocks merges it into a single block
+// large enough for the whole chain, so a reader reusing a pgn settles on one
+// block and allocating becomes a pointer bump.
+#define ARENA_BLOCK_SIZE 1024
+#define ARENA_ALIGN      8
+
+struct pgn_block {
+	struct pgn_block *next;
+	size_t size;
+	char data[];
+};
+
+static void arena_new_block(struct pgn_arena *arena, size_t size)
+{
+	struct pgn_block *block = malloc(sizeof(*block) + size);
+	if (block == NULL)
+		abort();
+	block->next = arena->blocks;
+	block->size = size;
+	arena->blocks = block;
+	arena->cur = block->data;
+	arena->end = block->data + size;
+}
+
+static void* arena_alloc(struct pgn_arena *arena, size_t size, size_t align)
+{
+	size_t pad = -(uintptr_t) arena->cur & (align - 1);
+	if (arena->cur == NULL || (size_t) (arena->end - arena->cur) < size + pad) {
+		// blocks double in size to keep the chain short
+		size_t next = (arena->blocks) ? arena->blocks->size * 2 : ARENA_BLOCK_SIZE;
+		arena_new_block(arena, (size > next) ? size : next);
+		pad = 0;
+	}
+	void *ptr = arena->cur + pad;
+	arena->cur += size + pad;
+	return ptr;
+}
+
+static void arena_reset(struct pgn_arena *arena)
+{
+	struct pgn_block *block = arena->blocks;
+	if (block == NULL)
+		return;
+
+	if (block->next) {
+		size_t size = 0;
+		while (block) {
+			struct pgn_block *next = block->next;
+			size += block->size;
+			free(block);
+			block = next;
+		}
+		arena->blocks = NULL;
+		arena_new_block(arena, size);
+		return;
+	}
+	arena->cur = block->data;
+}
+
+static void arena_release(struct pgn_arena *arena)
+{
+	struct pgn_block *block = arena->blocks;
+	while (block) {
+		struct pgn_block *next = block->next;
+		free(block);
+		block = next;
+	}
+	*arena = (struct pgn_arena) {0};
+}
+
+// stretchy buffer from skeeto's growable-buf, carved from an arena
 #define VEC_INIT_SIZE 8
 
 struct vec {
@@ -86,163 +189,622 @@ struct vec {
 
 #define containerof(ptr) ((struct vec *)((char *)(ptr) - offsetof(struct vec, buffer)))
 
-#define vec_free(vec)                             \
-	do {                                      \
-		if ((vec)) {                      \
-			free(containerof((vec))); \
-				(vec) = 0;        \
-		}                                 \
-	} while (0)
-
 #define vec_size(vec)    ((vec) ? containerof((vec))->size : 0)
 
 #define vec_len(vec)     ((vec) ? containerof((vec))->len : 0)
 
 #define vec_pop(vec) ((vec)[--containerof((vec))->len])
 
-#define vec_push(vec, e)                                         \
-	do {                                                     \
-		if (vec_len((vec)) == vec_size((vec)))           \
-			(vec) = vec_grow((vec), sizeof(*(vec))); \
-		(vec)[containerof((vec))->len++] = (e);          \
+#define vec_push(arena, vec, e)                                           \
+	do {                                                              \
+		if (vec_len((vec)) == vec_size((vec)))                    \
+			(vec) = vec_grow((arena), (vec), sizeof(*(vec))); \
+		(vec)[containerof((vec))->len++] = (e);                   \
 	} while (0)
 
-static void* vec_grow(void *v, int element_size)
+static void* vec_grow(struct pgn_arena *arena, void *v, int element_size)
 {
-	struct vec *vec;
-	if (v) {
-		vec = containerof(v);
-		vec->size += (vec->size == 0) ? VEC_INIT_SIZE : vec->size;
-		vec = realloc(vec, sizeof(struct vec) + element_size * vec->size);
-		if (!vec)
-			abort();
-	} else {
-		vec = malloc(sizeof(struct vec) + element_size * VEC_INIT_SIZE);
-		if (!vec)
+	struct vec *vec = (v) ? containerof(v) : NULL;
+	int size = (vec) ? vec->size * 2 : VEC_INIT_SIZE;
+
+	// grow in place if the vector was the last allocation
+	if (vec && arena->cur == vec->buffer + element_size * vec->size
+	        && arena->end - arena->cur >= element_size * vec->size) {
+		arena->cur += element_size * vec->size;
+		vec->size = size;
+		return vec->buffer;
+	}
+
+	struct vec *grown = arena_alloc(arena,
+		sizeof(struct vec) + element_size * size, ARENA_ALIGN);
+	grown->size = size;
+	grown->len = 0;
+	if (vec) {
+		grown->len = vec->len;
+		memcpy(grown->buffer, vec->buffer, element_size * vec->len);
+	}
+	return grown->buffer;
+}
+
+void* pgn_grow(void *buffer, size_t *size, size_t need, size_t element_size)
+{
+	if (need <= *size)
+		return buffer;
+
+	while (*size < need)
+		*size = (*size) ? *size * 2 : 1024;
+	buffer = realloc(buffer, *size * element_size);
+	if (buffer == NULL)
+		abort();
+	return buffer;
+}
+
+//
+// Tag atoms
+//
+
+// Tag names are interned into a hash table shared by all games and threads.
+// Lookups are lock free, entries are published with a release store of their
+// name once filled in and only inserting takes the lock. The table is never
+// more than 3/4 full, names beyond that are left without an atom. The roster
+// names have fixed atoms and are never put into the table, so they keep them
+// however full it gets.
+#define ATOMS_SIZE 4096
+
+struct atom_entry {
+	_Atomic(const char *) name;
+	int len;
+	int atom;
+};
+
+static struct atom_entry atoms[ATOMS_SIZE];
+static int atoms_used;
+static int atoms_next = PGN_ROSTER_MAX;
+static pthread_mutex_t atoms_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *roster[PGN_ROSTER_MAX] = {
+	[PGN_TAG_EVENT]  = "Event",
+	[PGN_TAG_SITE]   = "Site",
+	[PGN_TAG_DATE]   = "Date",
+	[PGN_TAG_ROUND]  = "Round",
+	[PGN_TAG_WHITE]  = "White",
+	[PGN_TAG_BLACK]  = "Black",
+	[PGN_TAG_RESULT] = "Result",
+};
+
+static int roster_atom(const char *name, int len)
+{
+	for (int atom = PGN_TAG_NONE + 1; atom < PGN_ROSTER_MAX; ++atom) {
+		if ((int) strlen(roster[atom]) == len && memcmp(roster[atom], name, len) == 0)
+			return atom;
+	}
+	return PGN_TAG_NONE;
+}
+
+// Probes for name starting at slot *i, leaving *i at the matching or at the
+// first empty slot.
+static bool atom_probe(const char *name, int len, unsigned *i)
+{
+	const char *entry;
+	while ((entry = atomic_load_explicit(&atoms[*i].name, memory_order_acquire))) {
+		if (atoms[*i].len == len && memcmp(entry, name, len) == 0)
+			return true;
+		*i = (*i + 1) & (ATOMS_SIZE - 1);
+	}
+	return false;
+}
+
+// Returns the atom of a name, assigning it one if insert is set.
+static int intern(const char *name, int len, bool insert)
+{
+	int atom = roster_atom(name, len);
+	if (atom != PGN_TAG_NONE)
+		return atom;
+
+	unsigned i = pgn_hash(name, len) & (ATOMS_SIZE - 1);
+	if (atom_probe(name, len, &i))
+		return atoms[i].atom;
+	if (!insert)
+		return PGN_TAG_NONE;
+
+	pthread_mutex_lock(&atoms_lock);
+	// another thread may have inserted it in the meantime
+	if (atom_probe(name, len, &i)) {
+		atom = atoms[i].atom;
+	} else if (atoms_used < ATOMS_SIZE / 4 * 3) {
+		char *copy = malloc(len);
+		if (copy == NULL)
 			abort();
-		vec->size = VEC_INIT_SIZE;
-		vec->len = 0;
+		memcpy(copy, name, len);
+		atom = atoms_next++;
+
+		atoms[i].len = len;
+		atoms[i].atom = atom;
+		atomic_store_explicit(&atoms[i].name, copy, memory_order_release);
+		++atoms_used;
+	}
+	pthread_mutex_unlock(&atoms_lock);
+	return atom;
+}
+
+int pgn_tag_atom(const char *name)
+{
+	return intern(name, strlen(name), true);
+}
+
+const char *pgn_get_tag_atom(const struct pgn *pgn, int atom)
+{
+	// the tags without an atom have different names
+	if (atom == PGN_TAG_NONE)
+		return NULL;
+	for (int i = 0; i < pgn->tagcount; ++i) {
+		if (pgn->tags[i].atom == atom)
+			return pgn->tags[i].desc;
+	}
+	return NULL;
+}
+
+const char *pgn_get_tag(const struct pgn *pgn, const char *name)
+{
+	// looking up a name no game had does not take a slot in the table
+	int atom = intern(name, strlen(name), false);
+	if (atom != PGN_TAG_NONE)
+		return pgn_get_tag_atom(pgn, atom);
+
+	// only names which did not fit into the table are left without an atom
+	for (int i = 0; i < pgn->tagcount; ++i) {
+		if (pgn->tags[i].atom == PGN_TAG_NONE && strcmp(pgn->tags[i].name, name) == 0)
+			return pgn->tags[i].desc;
 	}
-	return vec->buffer;
+	return NULL;
+}
+
+//
+// Character scanning
+//
+
+// Locale independent classification, the lexer only deals with ASCII.
+static inline bool is_digit(int c)
+{
+	return (unsigned) (c - '0') < 10;
+}
+
+static inline bool is_alnum(int c)
+{
+	return is_digit(c) || (unsigned) ((c | 0x20) - 'a') < 26;
+}
+
+static inline bool is_space(int c)
+{
+	return c == ' ' || (unsigned) (c - '\t') < 5;
+}
+
+// '/' is not a symbol character in the standard, but is needed to lex the
+// "1/2-1/2" termination marker as a single token
+static inline bool is_symbol(int c)
+{
+	return is_alnum(c) || c == '_' || c == '+' || c == '#'
+			   || c == '=' || c == ':' || c == '-' || c == '/';
+}
+
+// Vectorized versions of the above classify a whole block of input at once
+// and give a bitmask with a bit set for each byte in the class. Bytes above
+// 0x7f are negative as signed chars and so never fall in a range.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_WIDTH 32
+typedef __m256i simd;
+#define simd_load(p)   _mm256_loadu_si256((const __m256i *) (p))
+#define simd_set(c)    _mm256_set1_epi8((c))
+#define simd_eq(a, b)  _mm256_cmpeq_epi8((a), (b))
+#define simd_gt(a, b)  _mm256_cmpgt_epi8((a), (b))
+#define simd_or(a, b)  _mm256_or_si256((a), (b))
+#define simd_and(a, b) _mm256_and_si256((a), (b))
+#define simd_mask(a)   ((uint32_t) _mm256_movemask_epi8((a)))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_WIDTH 16
+typedef __m128i simd;
+#define simd_load(p)   _mm_loadu_si128((const __m128i *) (p))
+#define simd_set(c)    _mm_set1_epi8((c))
+#define simd_eq(a, b)  _mm_cmpeq_epi8((a), (b))
+#define simd_gt(a, b)  _mm_cmpgt_epi8((a), (b))
+#define simd_or(a, b)  _mm_or_si128((a), (b))
+#define simd_and(a, b) _mm_and_si128((a), (b))
+#define simd_mask(a)   ((uint32_t) _mm_movemask_epi8((a)))
+#endif
+
+#ifdef SIMD_WIDTH
+#define SIMD_ALL ((uint32_t) ((1ULL << SIMD_WIDTH) - 1))
+
+// bytes in [lo, hi]
+static inline simd simd_range(simd v, char lo, char hi)
+{
+	return simd_and(simd_gt(v, simd_set(lo - 1)), simd_gt(simd_set(hi + 1), v));
+}
+
+static inline uint32_t space_mask(simd v)
+{
+	return simd_mask(simd_or(simd_eq(v, simd_set(' ')), simd_range(v, '\t', '\r')));
+}
+
+static inline uint32_t symbol_mask(simd v)
+{
+	simd lower = simd_or(v, simd_set(0x20));
+	simd m = simd_or(simd_range(v, '0', '9'), simd_range(lower, 'a', 'z'));
+	m = simd_or(m, simd_or(simd_eq(v, simd_set('_')), simd_eq(v, simd_set('+'))));
+	m = simd_or(m, simd_or(simd_eq(v, simd_set('#')), simd_eq(v, simd_set('='))));
+	m = simd_or(m, simd_or(simd_eq(v, simd_set(':')), simd_eq(v, simd_set('-'))));
+	m = simd_or(m, simd_eq(v, simd_set('/')));
+	return simd_mask(m);
+}
+
+static inline uint32_t movetext_mask(simd v)
+{
+	simd m = simd_or(simd_eq(v, simd_set('\n')), simd_eq(v, simd_set('{')));
+	m = simd_or(m, simd_or(simd_eq(v, simd_set(';')), simd_eq(v, simd_set('*'))));
+	return simd_mask(simd_or(m, simd_eq(v, simd_set('-'))));
+}
+#endif
+
+// Skips whitespace in [p, end) and returns the first other character. Lines
+// are counted into y, and x is updated to be the column after the skipped
+// whitespace.
+static const char* scan_space(const char *p, const char *end, int *y, int *x)
+{
+	const char *line = NULL; // last newline skipped
+	const char *start = p;
+
+#ifdef SIMD_WIDTH
+	while (end - p >= SIMD_WIDTH) {
+		simd v = simd_load(p);
+		uint32_t space = space_mask(v);
+		uint32_t nl = simd_mask(simd_eq(v, simd_set('\n')));
+		int n = (space == SIMD_ALL) ? SIMD_WIDTH : __builtin_ctz(~space);
+
+		nl &= (uint32_t) ((1ULL << n) - 1);
+		if (nl) {
+			*y += __builtin_popcount(nl);
+			line = p + 31 - __builtin_clz(nl);
+		}
+		p += n;
+		if (n != SIMD_WIDTH)
+			break;
+	}
+#endif
+	while (p < end && is_space(*p)) {
+		if (*p == '\n') {
+			++*y;
+			line = p;
+		}
+		++p;
+	}
+
+	if (line)
+		*x = 1 + (p - line - 1);
+	else
+		*x += p - start;
+	return p;
+}
+
+// Returns the first character in [p, end) which is not a symbol character.
+static const char* scan_symbol(const char *p, const char *end)
+{
+#ifdef SIMD_WIDTH
+	while (end - p >= SIMD_WIDTH) {
+		uint32_t symbol = symbol_mask(simd_load(p));
+		if (symbol != SIMD_ALL)
+			return p + __builtin_ctz(~symbol);
+		p += SIMD_WIDTH;
+	}
+#endif
+	while (p < end && is_symbol(*p))
+		++p;
+	return p;
+}
+
+// Returns the first newline, comment start, '*' or '-' in [p, end), these are
+// the only characters which matter when skipping movetext. Every termination
+// marker has one of the last two.
+static const char* scan_movetext(const char *p, const char *end)
+{
+#ifdef SIMD_WIDTH
+	while (end - p >= SIMD_WIDTH) {
+		uint32_t found = movetext_mask(simd_load(p));
+		if (found)
+			return p + __builtin_ctz(found);
+		p += SIMD_WIDTH;
+	}
+#endif
+	while (p < end && *p != '\n' && *p != '{' && *p != ';' && *p != '*' && *p != '-')
+		++p;
+	return p;
+}
+
+// Returns the first occurence of c in [p, end), or end. Used for the ends of
+// strings and comments, memchr() is already vectorized by the C library.
+static inline const char* scan_char(const char *p, const char *end, char c)
+{
+	const char *found = memchr(p, c, end - p);
+	return (found) ? found : end;
 }
 
 //
 // Lexer
 //
 
-static inline bool is_symbol(char c)
+static inline long long input_offset(struct parser *parser, const char *p)
 {
-	return isalnum(c) || c == '_' || c == '+' || c == '#'
-			  || c == '=' || c == ':' || c == '-';
+	return parser->base + (p - parser->origin);
+}
+
+// Reads more of an unmapped input once the buffer is exhausted. The first
+// TOKEN_MAX characters of a token being lexed are kept at the front of the
+// buffer so its value stays valid.
+static bool refill(struct parser *parser)
+{
+	if (parser->buf == NULL)
+		return false;
+
+	size_t keep = 0;
+	if (parser->mark) {
+		keep = parser->end - parser->mark;
+		keep = (keep > TOKEN_MAX) ? TOKEN_MAX : keep;
+		memmove(parser->buf, parser->mark, keep);
+		parser->mark = parser->buf;
+	}
+
+	long long pos = input_offset(parser, parser->end);
+	parser->origin = parser->buf + keep;
+	parser->base = pos;
+	parser->cur = parser->end = parser->origin;
+
+	ssize_t n = read(parser->fd, parser->buf + keep, READ_SIZE);
+	if (n <= 0)
+		return false;
+
+	parser->end += n;
+	return true;
+}
+
+static inline int peek(struct parser *parser)
+{
+	if (parser->cur == parser->end && !refill(parser))
+		return EOF;
+	return (unsigned char) *parser->cur;
+}
+
+// Starts a token at the cursor, its value ends at the cursor once lexed.
+static inline void token_start(struct parser *parser, enum token_type type)
+{
+	parser->mark = parser->cur;
+	parser->token.type = type;
+	parser->token.len = 0;
+}
+
+static inline void token_end(struct parser *parser)
+{
+	parser->token.value = parser->mark;
+	parser->mark = NULL;
+}
+
+// Consumes the character under the cursor as part of the current token.
+static inline void token_push(struct parser *parser)
+{
+	parser->token.len += (parser->token.len < TOKEN_MAX);
+	++parser->cur;
+}
+
+// Consumes characters up to stop as part of the current token.
+static inline void token_push_to(struct parser *parser, const char *stop)
+{
+	int len = parser->token.len + (stop - parser->cur);
+	parser->token.len = (len < TOKEN_MAX) ? len : TOKEN_MAX;
+	parser->cur = stop;
 }
 
 // TODO: small buffer of parsed characters for error messages
 static void next_token(struct parser *parser)
 {
-	parser->x += parser->token.len - 1;
+	parser->x += parser->token.len;
 
-	// EOF token
-	if (parser->last_char == EOF) {
-		parser->token.type = TK_EOF;
-		return;
-	}
+	int c;
+	for (;;) {
+		// ignore whitespace
+		while (is_space(c = peek(parser))) {
+			parser->cur = scan_space(parser->cur, parser->end,
+			                         &parser->y, &parser->x);
+		}
 
-	// ignore whitespace
-	while (isspace(parser->last_char)) {
-		++parser->x;
-		if (parser->last_char == '\n') {
-			parser->x = 1;
-			++parser->y;
+		// ignore rest of line comments, the newline is left as whitespace
+		if (c == ';') {
+			do {
+				++parser->cur;
+				c = peek(parser);
+			} while (c != EOF && c != '\n' && c != '\r');
+			continue;
 		}
-		parser->last_char = getc(parser->file);
+
+		// ignore brace comments, these may contain '[' which would
+		// otherwise be mistaken for the start of the next game
+		if (c == '{') {
+			++parser->cur;
+			++parser->x;
+			while ((c = peek(parser)) != EOF) {
+				const char *stop = scan_char(parser->cur, parser->end, '}');
+				for (const char *p = parser->cur; p < stop; ++p) {
+					++parser->x;
+					if (*p == '\n') {
+						parser->x = 1;
+						++parser->y;
+					}
+				}
+				parser->cur = stop;
+				if (stop != parser->end) {
+					++parser->cur;
+					break;
+				}
+			}
+			continue;
+		}
+		break;
 	}
+	parser->token.pos = input_offset(parser, parser->cur);
 
-	// ignore comments
-	if (parser->last_char == ';') {
-		do {
-			parser->last_char = getc(parser->file);
-		} while (parser->last_char != EOF &&
-			 parser->last_char != '\n' &&
-			 parser->last_char != '\r');
-		++parser->y;
+	// EOF token
+	if (c == EOF) {
+		parser->token.type = TK_EOF;
+		parser->token.value = "";
+		parser->token.len = 0;
+		return;
 	}
 
 	// terminal tokens
-	switch (parser->last_char) {
-	case '[':  parser->token.type = TK_LBRACKET; break;
-	case ']':  parser->token.type = TK_RBRACKET; break;
-	case '(':  parser->token.type = TK_LPAREN;   break;
-	case ')':  parser->token.type = TK_RPAREN;   break;
-	case '<':  parser->token.type = TK_LANGLE;   break;
-	case '>':  parser->token.type = TK_RANGLE;   break;
-	case '.':  parser->token.type = TK_PERIOD;   break;
-	case '*':  parser->token.type = TK_ASTERISK; break;
-	default:   parser->token.type = TK_UNKNOWN;
-	}
-	if (parser->token.type != TK_UNKNOWN) {
-		parser->token.value[0] = parser->last_char;
-		parser->token.value[1] = '\0';
-		parser->token.len = 2;
-		parser->last_char = getc(parser->file);
+	enum token_type type;
+	switch (c) {
+	case '[':  type = TK_LBRACKET; break;
+	case ']':  type = TK_RBRACKET; break;
+	case '(':  type = TK_LPAREN;   break;
+	case ')':  type = TK_RPAREN;   break;
+	case '<':  type = TK_LANGLE;   break;
+	case '>':  type = TK_RANGLE;   break;
+	case '.':  type = TK_PERIOD;   break;
+	case '*':  type = TK_ASTERISK; break;
+	default:   type = TK_UNKNOWN;
+	}
+	if (type != TK_UNKNOWN) {
+		token_start(parser, type);
+		token_push(parser);
+		token_end(parser);
 		return;
 	}
 
 	// nag tokens
-	if (parser->last_char == '$') {
-		int len = 0;
+	if (c == '$') {
+		token_start(parser, TK_NAG);
 		do {
-			parser->token.value[len] = parser->last_char;
-			parser->last_char = getc(parser->file);
-			++len;
-		} while (isdigit(parser->last_char));
-
-		parser->token.type = TK_NAG;
-		parser->token.value[len] = '\0';
-		parser->token.len = len + 1;
+			token_push(parser);
+		} while (is_digit(peek(parser)));
+		token_end(parser);
 		return;
 	}
 
 	// string token
-	if (parser->last_char == '"') {
+	if (c == '"') {
 		++parser->x;
-		parser->token.type = TK_STRING;
-		int len = 0;
-		while ((parser->last_char = getc(parser->file)) != '"') {
-			parser->token.value[len] = parser->last_char;
-			++len;
-		}
-		parser->token.value[len] = '\0';
-		parser->token.len = len + 1;
+		++parser->cur;
+		token_start(parser, TK_STRING);
+		while ((c = peek(parser)) != '"' && c != EOF)
+			token_push_to(parser, scan_char(parser->cur, parser->end, '"'));
+		token_end(parser);
 
 		// skip closing quotes
-		parser->last_char = getc(parser->file);
+		parser->cur += (c == '"');
 		return;
 	}
 
 	// symbol token and integer token (special case of symbol token)
-	if (isalnum(parser->last_char)) {
-		bool all_ints = true;
-		int len = 0;
+	if (is_alnum(c)) {
+		token_start(parser, TK_SYMBOL);
 		do {
-			all_ints &= (isdigit(parser->last_char) != 0);
-			parser->token.value[len] = parser->last_char;
-			parser->last_char = getc(parser->file);
-			++len;
-		} while (is_symbol(parser->last_char));
+			token_push_to(parser, scan_symbol(parser->cur, parser->end));
+		} while (is_symbol(peek(parser)));
+		token_end(parser);
+
+		bool all_ints = true;
+		for (int i = 0; i < parser->token.len; ++i)
+			all_ints &= is_digit(parser->token.value[i]);
 
 		parser->token.type = all_ints ? TK_INTEGER : TK_SYMBOL;
-		parser->token.value[len] = '\0';
-		parser->token.len = len + 1;
 		return;
 	}
 
 	// unknown tokens
-	parser->token.type = TK_UNKNOWN;
-	parser->token.value[0] = parser->last_char;
-	parser->token.value[1] = '\0';
-	parser->token.len = 2;
+	token_start(parser, TK_UNKNOWN);
+	token_push(parser);
+	token_end(parser);
+}
+
+// characters kept before the cursor while skipping movetext, enough to tell
+// whether a '-' is part of a termination marker
+#define LOOKBEHIND 4
+
+// Like peek(), but keeps LOOKBEHIND characters before the cursor when the
+// buffer is refilled.
+static inline int peek_behind(struct parser *parser)
+{
+	const char *low = (parser->buf) ? parser->buf : parser->origin;
+	long behind = parser->cur - low;
+	parser->mark = parser->cur - ((behind < LOOKBEHIND) ? behind : LOOKBEHIND);
+	return peek(parser);
+}
+
+// Skips the '-' under the cursor and, if it is part of a "1-0", "0-1" or
+// "1/2-1/2" symbol, the rest of the marker. Returns whether it was one.
+static bool skip_dash(struct parser *parser)
+{
+	const char *low = (parser->buf) ? parser->buf : parser->origin;
+	const char *p = parser->cur++;
+	long behind = p - low;
 
-	parser->last_char = getc(parser->file);
+	const char *rest;
+	if (behind >= 3 && memcmp(p - 3, "1/2", 3) == 0
+	 && (behind == 3 || !is_symbol(p[-4])))
+		rest = "1/2";
+	else if (behind >= 1 && (p[-1] == '1' || p[-1] == '0')
+	      && (behind == 1 || !is_symbol(p[-2])))
+		rest = (p[-1] == '1') ? "0" : "1";
+	else
+		return false;
+
+	for (; *rest; ++rest) {
+		if (peek_behind(parser) != *rest)
+			return false;
+		++parser->cur;
+	}
+	int c = peek_behind(parser);
+	return c == EOF || !is_symbol(c);
+}
+
+// Skips raw input up to the termination marker or, if it is missing, the next
+// line starting with '[', which is taken to be the start of the next game.
+// Only comments need to be understood, as they may contain either.
+static void skip_movetext(struct parser *parser)
+{
+	int c;
+	while ((c = peek_behind(parser)) != EOF) {
+		parser->cur = scan_movetext(parser->cur, parser->end);
+		c = peek_behind(parser);
+
+		if (c == '*') {
+			++parser->cur;
+			break;
+		} else if (c == '-') {
+			if (skip_dash(parser))
+				break;
+		} else if (c == '\n') {
+			++parser->cur;
+			++parser->y;
+			parser->x = 1;
+			if (peek(parser) == '[')
+				break;
+		} else if (c == ';') {
+			while ((c = peek(parser)) != EOF && c != '\n')
+				parser->cur = scan_char(parser->cur, parser->end, '\n');
+		} else if (c == '{') {
+			while ((c = peek(parser)) != EOF && c != '}') {
+				const char *stop = scan_char(parser->cur, parser->end, '}');
+				for (const char *p = parser->cur; p < stop; ++p)
+					parser->y += (*p == '\n');
+				parser->cur = stop;
+			}
+			parser->cur += (c == '}');
+		}
+	}
+
+	parser->mark = NULL;
+	parser->token.len = 0;
+	next_token(parser);
 }
 
 //
@@ -268,18 +830,25 @@ static bool expect(struct parser *parser, enum token_type type)
 		parser->x,
 	 	token_str[type],
 	 	token_str[parser->token.type],
+	 	parser->token.len,
 	 	parser->token.value);
 	return false;
 }
 
-// copies the value of token to a buffer, the buffer must be freed
-static inline void copy_token_value(char **buffer, struct token *token)
+// copies the value of token to a null terminated buffer in the game's arena
+static inline void copy_token_value(struct parser *parser, char **buffer,
+                                    struct token *token)
 {
-	void *tmp = malloc(token->len);
-	if (tmp == NULL)
-		abort();
+	char *tmp = arena_alloc(&parser->pgn->arena, token->len + 1, 1);
+	memcpy(tmp, token->value, token->len);
+	tmp[token->len] = '\0';
 	*buffer = tmp;
-	memcpy(*buffer, token->value, token->len);
+}
+
+static inline bool token_equals(struct token *token, const char *str)
+{
+	return token->len == (int) strlen(str)
+	    && memcmp(token->value, str, token->len) == 0;
 }
 
 // tag is made of the following tokens: "[SYMBOL STRING]"
@@ -289,30 +858,40 @@ static void tag(struct parser *parser)
 
 	expect(parser, TK_LBRACKET);
 
-	copy_token_value(&tag.name, &parser->token);
+	tag.atom = check(parser, TK_SYMBOL)
+		? intern(parser->token.value, parser->token.len, true)
+		: PGN_TAG_NONE;
+	copy_token_value(parser, &tag.name, &parser->token);
 	expect(parser, TK_SYMBOL);
 
-	copy_token_value(&tag.desc, &parser->token);
+	copy_token_value(parser, &tag.desc, &parser->token);
 	expect(parser, TK_STRING);
 
 	expect(parser, TK_RBRACKET);
 
 	if (parser->unhandled_error) {
 		fprintf(stderr, parser_err, parser->py, parser->px, "tag");
-		free(tag.name);
-		free(tag.desc);
 		parser->unhandled_error = false;
 		parser->result = PGN_TAG_PARSE_ERROR;
 	} else {
-		vec_push(parser->pgn->tags, tag);
+		vec_push(&parser->pgn->arena, parser->pgn->tags, tag);
 	}
 }
 
-// TODO: handle comments and NAG tokens
+static bool is_termination(struct token *token)
+{
+	return token_equals(token, "*")
+	    || token_equals(token, "1-0")
+	    || token_equals(token, "0-1")
+	    || token_equals(token, "1/2-1/2");
+}
+
+// TODO: handle NAG tokens
 // Move is made of the following tokens: "(INTEGER PERIOD+)? SYMBOL"
 // The "(Integer PERIOD+)?" portion is known as the move indicator
 // and is optional for imports.
-static void movetext(struct parser *parser)
+// Returns true if the symbol is a termination marker, which ends the game.
+static bool movetext(struct parser *parser)
 {
 	struct pgn_move move;
 
@@ -324,81 +903,415 @@ static void movetext(struct parser *parser)
 		} while (check(parser, TK_PERIOD));
 	}
 
-	if (check(parser, TK_SYMBOL)) {
-		memcpy(&move.text, &parser->token.value, parser->token.len);
-		next_token(parser);
-	} else if (check(parser, TK_ASTERISK)) {
-		memcpy(&move.text, &parser->token.value, parser->token.len);
+	if (!check(parser, TK_SYMBOL) && !check(parser, TK_ASTERISK))
+		return false;
+
+	if (is_termination(&parser->token)) {
 		next_token(parser);
+		return true;
 	}
 
+	if (parser->on_move) {
+		if (!parser->on_move(parser->on_move_data, parser->token.value, parser->token.len))
+			parser->unhandled_error = true;
+	} else if (parser->token.len >= (int) sizeof(move.text)) {
+		parser->unhandled_error = true;
+	} else {
+		memcpy(&move.text, parser->token.value, parser->token.len);
+		move.text[parser->token.len] = '\0';
+		move.nag = 0;
+		move.comment = NULL;
+	}
+	next_token(parser);
+	++parser->plies;
+
 	if (parser->unhandled_error) {
 		fprintf(stderr, parser_err, parser->py, parser->px, "move");
 		parser->unhandled_error = false;
 		parser->result = PGN_MOVE_PARSE_ERROR;
-	} else {
-		vec_push(parser->pgn->moves, move);
+	} else if (!parser->on_move) {
+		vec_push(&parser->pgn->arena, parser->pgn->moves, move);
 	}
+	return false;
 }
 
-enum pgn_result pgn_read(struct pgn* pgn, char* filename)
+struct pgn_reader *pgn_open(const char *filename, int flags)
 {
-	// initialization
-	pgn->tags = 0;
-	pgn->moves = 0;
-	struct parser parser = {
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	struct pgn_reader *reader = malloc(sizeof(*reader));
+	if (reader == NULL)
+		abort();
+
+	reader->parser = (struct parser) {
 		.result = PGN_OK,
-		.file  = fopen(filename, "r"),
-		.last_char = ' ',
+		.fd = fd,
 		.y = 1,
 		.x = 1,
-		.pgn = pgn
+		.flags = flags,
 	};
+	struct parser *parser = &reader->parser;
 
-	if (parser.file == NULL)
-		return PGN_FILE_ERROR;
+	// regular files are mapped and lexed in place, anything else is read
+	// through a buffer
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			madvise(map, st.st_size, MADV_SEQUENTIAL);
+			parser->map = map;
+			parser->mapsize = st.st_size;
+			parser->cur = parser->origin = parser->map;
+			parser->end = parser->map + parser->mapsize;
+		}
+	}
+	if (parser->map == NULL) {
+		parser->buf = malloc(TOKEN_MAX + READ_SIZE);
+		if (parser->buf == NULL)
+			abort();
+		parser->cur = parser->end = parser->origin = parser->buf;
+	}
 
-	// parsing
-	next_token(&parser);
-	while (parser.token.type != TK_EOF) {
-		parser.px = parser.x;
-		parser.py = parser.y;
-		switch (parser.token.type) {
-		case TK_LBRACKET: tag(&parser);      break;
-		case TK_INTEGER:  movetext(&parser); break;
-		case TK_SYMBOL:	  movetext(&parser); break;
-		case TK_ASTERISK: movetext(&parser); break;
-		default: 	  next_token(&parser);
+	next_token(parser);
+	return reader;
+}
+
+static enum pgn_result parse_game(struct parser *parser, struct pgn *pgn)
+{
+	// initialization, memory of the previous game is reused
+	pgn_clear(pgn);
+	pgn->offset = parser->token.pos;
+	parser->pgn = pgn;
+	parser->result = PGN_OK;
+	parser->plies = 0;
+
+	// parsing, a game ends at its termination marker or, if the marker is
+	// missing, at the first tag following the movetext
+	bool terminated = false;
+	while (!terminated && !check(parser, TK_EOF)) {
+		parser->px = parser->x;
+		parser->py = parser->y;
+		switch (parser->token.type) {
+		case TK_LBRACKET:
+			if (parser->plies > 0)
+				goto done;
+			tag(parser);
+			break;
+		case TK_INTEGER:
+		case TK_SYMBOL:
+		case TK_ASTERISK:
+			if (parser->flags & PGN_HEADERS_ONLY) {
+				// the movetext may be no more than the marker
+				if (is_termination(&parser->token))
+					next_token(parser);
+				else
+					skip_movetext(parser);
+				terminated = true;
+				break;
+			}
+			terminated = movetext(parser);
+			break;
+		default:
+			next_token(parser);
 		}
 	}
+done:
 
 	// finalization
 	pgn->tagcount = vec_len(pgn->tags);
 	pgn->movecount = vec_len(pgn->moves);
+	pgn->length = parser->token.pos - pgn->offset;
 
-	char* last = pgn->moves[pgn->movecount - 1].text;
-	if (strcmp(last, "*") == 0
-		|| strcmp(last, "1-0") == 0
-		|| strcmp(last, "0-1") == 0
-		|| strcmp(last, "1/2-1/2") == 0
-	) {
-		vec_pop(pgn->moves);
-		--pgn->movecount;
-	} else {
+	if (!terminated && pgn->tagcount == 0 && parser->plies == 0)
+		return PGN_EOF;
+
+	if (!terminated)
 		fprintf(stderr, "Warning: Movetext termination marker not found!\n");
+
+	return parser->result;
+}
+
+enum pgn_result pgn_next_game(struct pgn_reader *reader, struct pgn *pgn)
+{
+	return parse_game(&reader->parser, pgn);
+}
+
+enum pgn_result pgn_seek(struct pgn_reader *reader, long long offset)
+{
+	struct parser *parser = &reader->parser;
+
+	if (parser->map) {
+		if (offset < 0 || offset > (long long) parser->mapsize)
+			return PGN_FILE_ERROR;
+		parser->cur = parser->map + offset;
+	} else {
+		if (lseek(parser->fd, offset, SEEK_SET) < 0)
+			return PGN_FILE_ERROR;
+		parser->cur = parser->end = parser->origin = parser->buf;
+		parser->base = offset;
 	}
 
-	// cleanup
-	fclose(parser.file);
-	return parser.result;
+	// lines are counted from the offset from now on
+	parser->y = 1;
+	parser->x = 1;
+	parser->token.len = 0;
+	next_token(parser);
+	return PGN_OK;
 }
 
-void pgn_free(struct pgn *pgn)
+void pgn_set_move_handler(struct pgn_reader *reader, pgn_move_handler handler, void *data)
 {
-	for (int i = 0; i < pgn->tagcount; ++i) {
-		free(pgn->tags[i].name);
-		free(pgn->tags[i].desc);
+	reader->parser.on_move = handler;
+	reader->parser.on_move_data = data;
+}
+
+void pgn_close(struct pgn_reader *reader)
+{
+	struct parser *parser = &reader->parser;
+	if (parser->map)
+		munmap(parser->map, parser->mapsize);
+	free(parser->buf);
+	close(parser->fd);
+	free(reader);
+}
+
+enum pgn_result pgn_read(struct pgn* pgn, char* filename)
+{
+	*pgn = (struct pgn) {0};
+	struct pgn_reader *reader = pgn_open(filename, 0);
+	if (reader == NULL)
+		return PGN_FILE_ERROR;
+
+	enum pgn_result result = pgn_next_game(reader, pgn);
+
+	pgn_close(reader);
+	return result;
+}
+
+//
+// Parallel reading
+//
+
+// games read from one byte range of a file by a worker thread, note that
+// error locations are relative to the start of the range
+struct shard {
+	pthread_t thread;
+	struct parser *parser;
+	long long start;	// offset of the first game
+	long long stop;		// games from here on are left to the next shard
+	long long end;		// offset following the last game
+	struct pgn *games;
+	int count, size;
+	enum pgn_result result;
+};
+
+// whether the text before p, up to begin, ends with a termination marker
+static bool follows_termination(const char *p, const char *begin)
+{
+	static const char *markers[] = { "1-0", "0-1", "1/2-1/2", "*" };
+	for (int i = 0; i < 4; ++i) {
+		int len = strlen(markers[i]);
+		if (p - begin >= len && memcmp(p - len, markers[i], len) == 0)
+			return true;
+	}
+	return false;
+}
+
+// Finds the first game likely starting at or after pos, that is an "[Event"
+// tag at the start of a line which follows a termination marker. A comment
+// may still hold such lines, so where the shards start is checked once read.
+static const char* find_game_start(const char *pos, const char *begin, const char *end)
+{
+	while ((pos = memchr(pos, '\n', end - pos)) != NULL) {
+		const char *line = ++pos;
+		if (end - line < 6 || memcmp(line, "[Event", 6) != 0)
+			continue;
+
+		const char *prev = line;
+		while (prev > begin && is_space(prev[-1]))
+			--prev;
+		if (follows_termination(prev, begin))
+			return line;
+	}
+	return end;
+}
+
+// Sets up shard to read the games of a mapped file starting in [start, stop),
+// the last of which may run past stop.
+static void shard_init(struct shard *shard, struct parser *parser,
+                       const struct parser *file, long long start, long long stop)
+{
+	*parser = (struct parser) {
+		.result = PGN_OK,
+		.fd = -1,
+		.cur = file->map + start,
+		.end = file->map + file->mapsize,
+		.origin = file->map,
+		.y = 1,
+		.x = 1,
+		.flags = file->flags,
+	};
+	next_token(parser);
+
+	*shard = (struct shard) {
+		.parser = parser,
+		.start = parser->token.pos,
+		.stop = stop,
+	};
+}
+
+static void* read_shard(void *arg)
+{
+	struct shard *shard = arg;
+	struct parser *parser = shard->parser;
+	struct pgn pgn = {0};
+	enum pgn_result result;
+
+	while (parser->token.pos < shard->stop
+	    && (result = parse_game(parser, &pgn)) != PGN_EOF) {
+		if (shard->result == PGN_OK)
+			shard->result = result;
+
+		if (shard->count == shard->size) {
+			shard->size = (shard->size) ? shard->size * 2 : 64;
+			shard->games = realloc(shard->games,
+			                       shard->size * sizeof(*shard->games));
+			if (shard->games == NULL)
+				abort();
+		}
+		shard->games[shard->count++] = pgn;
+		pgn = (struct pgn) {0};
 	}
-	vec_free(pgn->tags);
-	vec_free(pgn->moves);
+	pgn_free(&pgn);
+	shard->end = parser->token.pos;
+	return NULL;
+}
+
+static void shard_free(struct shard *shard)
+{
+	for (int i = 0; i < shard->count; ++i)
+		pgn_free(&shard->games[i]);
+	free(shard->games);
+}
+
+enum pgn_result pgn_read_all(const char *filename, int flags, int nthreads,
+                             struct pgn **games, int *count)
+{
+	*games = NULL;
+	*count = 0;
+
+	struct pgn_reader *reader = pgn_open(filename, flags);
+	if (reader == NULL)
+		return PGN_FILE_ERROR;
+
+	if (nthreads < 1)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	// only mapped inputs can be split
+	if (reader->parser.map == NULL || nthreads < 1)
+		nthreads = 1;
+
+	struct shard *shards = calloc(nthreads, sizeof(*shards));
+	struct parser *parsers = calloc(nthreads, sizeof(*parsers));
+	if (shards == NULL || parsers == NULL)
+		abort();
+
+	if (nthreads == 1) {
+		shards[0].parser = &reader->parser;
+		shards[0].stop = LLONG_MAX;
+		read_shard(&shards[0]);
+	} else {
+		const struct parser *file = &reader->parser;
+		const char *begin = file->map;
+		const char *end = begin + file->mapsize;
+		size_t chunk = (end - begin) / nthreads;
+
+		const char *start = begin;
+		for (int i = 0; i < nthreads; ++i) {
+			const char *stop = (i == nthreads - 1) ? end
+				: find_game_start(begin + chunk * (i + 1), begin, end);
+			if (stop < start)
+				stop = start;
+
+			shard_init(&shards[i], &parsers[i], file, start - begin, stop - begin);
+			if (pthread_create(&shards[i].thread, NULL, read_shard, &shards[i]))
+				abort();
+			start = stop;
+		}
+		for (int i = 0; i < nthreads; ++i)
+			pthread_join(shards[i].thread, NULL);
+
+		// A shard which did not start where the one before ended started
+		// inside a game, its range is read again from the right place.
+		for (int i = 1; i < nthreads; ++i) {
+			if (shards[i].start == shards[i - 1].end)
+				continue;
+			long long stop = shards[i].stop;
+			shard_free(&shards[i]);
+			shard_init(&shards[i], &parsers[i], file, shards[i - 1].end, stop);
+			read_shard(&shards[i]);
+		}
+	}
+
+	// merge the shards back in file order
+	enum pgn_result result = PGN_OK;
+	int total = 0;
+	for (int i = 0; i < nthreads; ++i)
+		total += shards[i].count;
+
+	*games = malloc((total ? total : 1) * sizeof(**games));
+	if (*games == NULL)
+		abort();
+	for (int i = 0; i < nthreads; ++i) {
+		// a shard without games may have no array to copy from
+		if (shards[i].count > 0)
+			memcpy(*games + *count, shards[i].games,
+			       shards[i].count * sizeof(**games));
+		*count += shards[i].count;
+		if (result == PGN_OK)
+			result = shards[i].result;
+		free(shards[i].games);
+	}
+
+	free(parsers);
+	free(shards);
+	pgn_close(reader);
+	return result;
+}
+
+void pgn_clear(struct pgn *pgn)
+{
+	arena_reset(&pgn->arena);
+	pgn->tags = 0;
+	pgn->moves = 0;
+	pgn->tagcount = 0;
+	pgn->movecount = 0;
+	pgn->offset = 0;
+	pgn->length = 0;
+}
+
+void pgn_add_tag(struct pgn *pgn, const char *name, const char *desc)
+{
+	int name_len = strlen(name);
+	int desc_len = strlen(desc);
+	struct pgn_tag tag = {
+		.name = arena_alloc(&pgn->arena, name_len + 1, 1),
+		.desc = arena_alloc(&pgn->arena, desc_len + 1, 1),
+		.atom = intern(name, name_len, true),
+	};
+	memcpy(tag.name, name, name_len + 1);
+	memcpy(tag.desc, desc, desc_len + 1);
+
+	vec_push(&pgn->arena, pgn->tags, tag);
+	pgn->tagcount = vec_len(pgn->tags);
+}
+
+void pgn_free(struct pgn *pgn)
+{
+	arena_release(&pgn->arena);
+	pgn->tags = 0;
+	pgn->moves = 0;
+	pgn->tagcount = 0;
+	pgn->movecount = 0;
 }
@@ -1,16 +1,35 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <stdbool.h>
+
 enum pgn_result {
 	PGN_OK,
 	PGN_FILE_ERROR,
 	PGN_LEX_ERROR,
 	PGN_TAG_PARSE_ERROR,
 	PGN_MOVE_PARSE_ERROR,
+	PGN_EOF,		// no games left to read
+};
+
+// Tag names are interned into integer atoms shared by all games, so tags can
+// be compared without comparing strings. The seven tag roster has fixed atoms,
+// other names are assigned one the first time they are read.
+enum pgn_roster {
+	PGN_TAG_NONE,
+	PGN_TAG_EVENT,
+	PGN_TAG_SITE,
+	PGN_TAG_DATE,
+	PGN_TAG_ROUND,
+	PGN_TAG_WHITE,
+	PGN_TAG_BLACK,
+	PGN_TAG_RESULT,
+	PGN_ROSTER_MAX
 };
 
 struct pgn_tag {
 	char *name, *desc;
+	int atom;	// atom of name
 };
 
 struct pgn_move {
@@ -19,15 +38,76 @@ struct pgn_move {
 	char *comment;  // comment (optional)
 };
 
+// Memory backing the strings and arrays of a game, see pgn.c
+struct pgn_block;
+struct pgn_arena {
+	struct pgn_block *blocks;
+	char *cur, *end;
+};
+
 // TODO: technically the moves are plies, rename?
 struct pgn {
 	struct pgn_tag  *tags;	// all tags in parsed order
 	int tagcount;
 	struct pgn_move *moves;	// all moves (white and black) in parsed order
 	int movecount;
+	long long offset;	// location of the game in the file, in bytes
+	long long length;
+	struct pgn_arena arena;
 };
 
+// Reads the first game of a file, returns PGN_EOF if there is none.
 enum pgn_result pgn_read(struct pgn *pgn, char *filename);
+// Releases all memory of pgn at once.
 void pgn_free(struct pgn *pgn);
+// Empties pgn, which must be zeroed or hold a game, keeping its memory.
+void pgn_clear(struct pgn *pgn);
+// Appends a copy of a tag to pgn.
+void pgn_add_tag(struct pgn *pgn, const char *name, const char *desc);
+
+// Returns the atom of a tag name, assigning it one if no game read so far had
+// it. Returns PGN_TAG_NONE only once the table of names is full.
+int pgn_tag_atom(const char *name);
+// Return the value of a tag, or NULL if pgn does not have the tag. Filtering
+// many games on a tag should look up its atom once and use pgn_get_tag_atom().
+const char *pgn_get_tag_atom(const struct pgn *pgn, int atom);
+const char *pgn_get_tag(const struct pgn *pgn, const char *name);
+
+// Streaming reader for files containing many games, only the game currently
+// being read is held in memory.
+struct pgn_reader;
+
+enum pgn_flags {
+	// Only tags are read, movetext is skipped with a raw scan for the
+	// termination marker, or the next line starting with '[' if there is
+	// none, and games are returned without moves.
+	PGN_HEADERS_ONLY = 1 << 0,
+};
+
+// Returns NULL if the file could not be opened, flags are enum pgn_flags.
+struct pgn_reader *pgn_open(const char *filename, int flags);
+// Reads the next game into pgn, which must be zeroed or hold a previous game.
+// The memory of the previous game is reused, so pgn only needs to be freed
+// with pgn_free() once done.
+enum pgn_result pgn_next_game(struct pgn_reader *reader, struct pgn *pgn);
+// Moves the reader to offset, which should be the offset of a game.
+// Returns PGN_FILE_ERROR if the input cannot seek there.
+enum pgn_result pgn_seek(struct pgn_reader *reader, long long offset);
+void pgn_close(struct pgn_reader *reader);
+
+// Takes the SAN of every move as it is parsed, in place of storing the moves
+// in the game. san is not null terminated. Returning false makes the move a
+// PGN_MOVE_PARSE_ERROR.
+typedef bool (*pgn_move_handler)(void *data, const char *san, int len);
+// Passes the moves of the following games to handler, which may be NULL to
+// store them again.
+void pgn_set_move_handler(struct pgn_reader *reader, pgn_move_handler handler, void *data);
+
+// Reads every game of a file, splitting it at game boundaries and parsing the
+// parts on nthreads threads, or one per CPU if nthreads is 0. On return games
+// holds count games in file order, each must be freed with pgn_free() and the
+// array itself with free(). Returns the first error of any game.
+enum pgn_result pgn_read_all(const char *filename, int flags, int nthreads,
+                             struct pgn **games, int *count);
 
 #endif
@@ -0,0 +1,344 @@
+#include "pgn_bin.h"
+
+#include "pgn.h"
+#include "pgn_internal.h"
+#include "pgn_ext.h"
+#include "chess.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The file starts with a header holding the offset of the dictionary, which is
+// written last, followed by the games. Each game is
+//
+//   tag count, then the dictionary ids of the name and value of every tag
+//   ply count, then one byte for every ply
+//
+// Counts and ids are varints. The dictionary is a string count followed by the
+// strings, each prefixed by its length.
+#define BIN_MAGIC "PGNBIN2\n"
+
+struct bin_header {
+	char magic[8];
+	uint64_t dictionary;	// offset of the dictionary
+};
+
+struct pgn_bin_writer {
+	FILE *file;
+	bool failed;
+	uint64_t offset;
+
+	// dictionary, strings by id and a hash table of id + 1, 0 being empty
+	char **strings;
+	size_t count, strings_size;
+	int *table;
+	size_t table_size;
+
+	// the game being written
+	unsigned char *buf;
+	size_t len, buf_size;
+};
+
+struct pgn_bin_reader {
+	FILE *file;
+	uint64_t dictionary;
+
+	char *data;	// the strings of the dictionary, null terminated
+	char **strings;
+	uint64_t count;
+};
+
+// Moves are numbered by their place in the sorted list of legal moves of the
+// position, so the numbers only depend on the position and not on the order
+// in which they are generated.
+static int position_moves(struct board *board, enum color color, move *moves)
+{
+	move *last = generate_legal_moves(board, moves, color);
+
+	int count = last - moves;
+	for (int i = 1; i < count; ++i) {
+		move move = moves[i];
+		int j = i;
+		for (; j > 0 && moves[j - 1] > move; --j)
+			moves[j] = moves[j - 1];
+		moves[j] = move;
+	}
+	return count;
+}
+
+static void put_byte(struct pgn_bin_writer *writer, unsigned char byte)
+{
+	writer->buf = pgn_grow(writer->buf, &writer->buf_size, writer->len + 1, 1);
+	writer->buf[writer->len++] = byte;
+}
+
+static void put_varint(struct pgn_bin_writer *writer, uint64_t value)
+{
+	while (value >= 0x80) {
+		put_byte(writer, (value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	put_byte(writer, value);
+}
+
+static void flush(struct pgn_bin_writer *writer)
+{
+	if (fwrite(writer->buf, 1, writer->len, writer->file) != writer->len)
+		writer->failed = true;
+	writer->offset += writer->len;
+	writer->len = 0;
+}
+
+// table stays at most half full
+static void rehash(struct pgn_bin_writer *writer)
+{
+	free(writer->table);
+	writer->table_size = (writer->table_size) ? writer->table_size * 2 : 1024;
+	writer->table = calloc(writer->table_size, sizeof(*writer->table));
+	if (writer->table == NULL)
+		abort();
+
+	size_t mask = writer->table_size - 1;
+	for (size_t id = 0; id < writer->count; ++id) {
+		size_t i = pgn_hash(writer->strings[id], strlen(writer->strings[id])) & mask;
+		while (writer->table[i])
+			i = (i + 1) & mask;
+		writer->table[i] = id + 1;
+	}
+}
+
+// returns the id of string, adding it to the dictionary if needed
+static uint64_t dictionary_id(struct pgn_bin_writer *writer, const char *string)
+{
+	if (2 * (writer->count + 1) > writer->table_size)
+		rehash(writer);
+
+	size_t mask = writer->table_size - 1;
+	size_t i = pgn_hash(string, strlen(string)) & mask;
+	for (; writer->table[i]; i = (i + 1) & mask) {
+		int id = writer->table[i] - 1;
+		if (strcmp(writer->strings[id], string) == 0)
+			return id;
+	}
+
+	writer->strings = pgn_grow(writer->strings, &writer->strings_size,
+	                           writer->count + 1, sizeof(*writer->strings));
+	writer->strings[writer->count] = strdup(string);
+	if (writer->strings[writer->count] == NULL)
+		abort();
+	writer->table[i] = ++writer->count;
+	return writer->count - 1;
+}
+
+struct pgn_bin_writer *pgn_bin_create(const char *filename)
+{
+	FILE *file = fopen(filename, "wb");
+	if (file == NULL)
+		return NULL;
+
+	struct pgn_bin_writer *writer = calloc(1, sizeof(*writer));
+	if (writer == NULL)
+		abort();
+	writer->file = file;
+
+	// the dictionary offset is filled in once it is known
+	struct bin_header header = { .magic = BIN_MAGIC };
+	if (fwrite(&header, sizeof(header), 1, file) != 1)
+		writer->failed = true;
+	writer->offset = sizeof(header);
+	return writer;
+}
+
+enum pgn_result pgn_bin_write(struct pgn_bin_writer *writer, const struct pgn *pgn,
+                              const move *moves, int count)
+{
+	struct board board;
+	board_init(&board);
+
+	writer->len = 0;
+	put_varint(writer, pgn->tagcount);
+	for (int i = 0; i < pgn->tagcount; ++i) {
+		put_varint(writer, dictionary_id(writer, pgn->tags[i].name));
+		put_varint(writer, dictionary_id(writer, pgn->tags[i].desc));
+	}
+
+	put_varint(writer, count);
+	move list[MAX_MOVES];
+	for (int i = 0; i < count; ++i) {
+		int n = position_moves(&board, i & 1, list);
+		int index = 0;
+		while (index < n && list[index] != moves[i])
+			++index;
+		if (index == n || index > UINT8_MAX) {
+			writer->len = 0;
+			return PGN_MOVE_PARSE_ERROR;
+		}
+
+		put_byte(writer, index);
+		board_move(&board, moves[i]);
+	}
+
+	flush(writer);
+	return PGN_OK;
+}
+
+enum pgn_result pgn_bin_finish(struct pgn_bin_writer *writer)
+{
+	struct bin_header header = {
+		.magic = BIN_MAGIC,
+		.dictionary = writer->offset,
+	};
+
+	put_varint(writer, writer->count);
+	for (size_t id = 0; id < writer->count; ++id) {
+		size_t len = strlen(writer->strings[id]);
+		put_varint(writer, len);
+		for (size_t i = 0; i < len; ++i)
+			put_byte(writer, writer->strings[id][i]);
+		free(writer->strings[id]);
+	}
+	flush(writer);
+
+	bool ok = !writer->failed;
+	ok &= (fseek(writer->file, 0, SEEK_SET) == 0);
+	ok &= (fwrite(&header, sizeof(header), 1, writer->file) == 1);
+	ok &= (fclose(writer->file) == 0);
+
+	free(writer->strings);
+	free(writer->table);
+	free(writer->buf);
+	free(writer);
+	return ok ? PGN_OK : PGN_FILE_ERROR;
+}
+
+static bool get_varint(FILE *file, uint64_t *value)
+{
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		int c = getc(file);
+		if (c == EOF)
+			return false;
+		*value |= (uint64_t) (c & 0x7f) << shift;
+		if (!(c & 0x80))
+			return true;
+	}
+	return false;
+}
+
+// Every string takes at least one byte more in the file than its length, so
+// the dictionary fits in as many bytes as it takes in the file.
+static bool load_dictionary(struct pgn_bin_reader *reader, size_t size)
+{
+	reader->data = malloc(size);
+	if (reader->data == NULL)
+		abort();
+
+	if (!get_varint(reader->file, &reader->count) || reader->count > size)
+		return false;
+	reader->strings = malloc(reader->count * sizeof(*reader->strings));
+	if (reader->strings == NULL)
+		abort();
+
+	char *p = reader->data;
+	for (uint64_t id = 0; id < reader->count; ++id) {
+		uint64_t len;
+		if (!get_varint(reader->file, &len) || len >= size - (p - reader->data))
+			return false;
+		if (fread(p, 1, len, reader->file) != len)
+			return false;
+		p[len] = '\0';
+		reader->strings[id] = p;
+		p += len + 1;
+	}
+	return true;
+}
+
+struct pgn_bin_reader *pgn_bin_open(const char *filename)
+{
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL)
+		return NULL;
+
+	struct pgn_bin_reader *reader = calloc(1, sizeof(*reader));
+	if (reader == NULL)
+		abort();
+	reader->file = file;
+
+	struct bin_header header;
+	long size = -1;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, BIN_MAGIC, sizeof(header.magic)) == 0
+		&& fseek(file, 0, SEEK_END) == 0
+		&& (size = ftell(file)) >= 0
+		&& header.dictionary >= sizeof(header)
+		&& header.dictionary < (uint64_t) size
+		&& fseek(file, header.dictionary, SEEK_SET) == 0
+		&& load_dictionary(reader, size - header.dictionary)
+		&& fseek(file, sizeof(header), SEEK_SET) == 0;
+	if (!ok) {
+		pgn_bin_close(reader);
+		return NULL;
+	}
+
+	reader->dictionary = header.dictionary;
+	return reader;
+}
+
+enum pgn_result pgn_bin_next_game(struct pgn_bin_reader *reader, struct pgn *pgn,
+                                  struct pgn_movelist *moves)
+{
+	pgn_clear(pgn);
+	moves->count = 0;
+
+	long offset = ftell(reader->file);
+	if (offset < 0)
+		return PGN_FILE_ERROR;
+	if ((uint64_t) offset >= reader->dictionary)
+		return PGN_EOF;
+
+	uint64_t tagcount, name, desc;
+	if (!get_varint(reader->file, &tagcount))
+		return PGN_FILE_ERROR;
+	for (uint64_t i = 0; i < tagcount; ++i) {
+		if (!get_varint(reader->file, &name) || name >= reader->count
+		 || !get_varint(reader->file, &desc) || desc >= reader->count)
+			return PGN_FILE_ERROR;
+		pgn_add_tag(pgn, reader->strings[name], reader->strings[desc]);
+	}
+
+	uint64_t count;
+	if (!get_varint(reader->file, &count))
+		return PGN_FILE_ERROR;
+
+	struct board board;
+	board_init(&board);
+
+	move list[MAX_MOVES];
+	for (uint64_t i = 0; i < count; ++i) {
+		int index = getc(reader->file);
+		if (index == EOF)
+			return PGN_FILE_ERROR;
+
+		int n = position_moves(&board, i & 1, list);
+		if (index >= n) {
+			// skip to the next game
+			fseek(reader->file, count - i - 1, SEEK_CUR);
+			return PGN_MOVE_PARSE_ERROR;
+		}
+
+		pgn_movelist_push(moves, list[index]);
+		board_move(&board, list[index]);
+	}
+	return PGN_OK;
+}
+
+void pgn_bin_close(struct pgn_bin_reader *reader)
+{
+	fclose(reader->file);
+	free(reader->strings);
+	free(reader->data);
+	free(reader);
+}
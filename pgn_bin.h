@@ -0,0 +1,33 @@
+#ifndef PGN_BIN_H
+#define PGN_BIN_H
+
+#include "pgn.h"
+#include "pgn_ext.h"
+
+// Compact binary format for games starting from the initial position. Every
+// ply is stored as a single byte, the index of the move in the list of legal
+// moves of the position, and tags are stored as references into a dictionary
+// of all tag names and values of the file.
+
+struct pgn_bin_writer;
+struct pgn_bin_reader;
+
+// Creates a binary file, returns NULL if it cannot be created.
+struct pgn_bin_writer *pgn_bin_create(const char *filename);
+// Appends the tags of pgn and its moves to the file. Returns
+// PGN_MOVE_PARSE_ERROR without writing anything if a move is not possible.
+enum pgn_result pgn_bin_write(struct pgn_bin_writer *writer, const struct pgn *pgn,
+                              const move *moves, int count);
+// Writes the dictionary and closes the file, returns PGN_FILE_ERROR if any
+// write failed.
+enum pgn_result pgn_bin_finish(struct pgn_bin_writer *writer);
+
+// Opens a binary file, returns NULL if it cannot be read or is not one.
+struct pgn_bin_reader *pgn_bin_open(const char *filename);
+// Reads the next game, its tags into pgn and its moves into moves, both must
+// be zeroed or hold a previous game. Returns PGN_EOF after the last game.
+enum pgn_result pgn_bin_next_game(struct pgn_bin_reader *reader, struct pgn *pgn,
+                                  struct pgn_movelist *moves);
+void pgn_bin_close(struct pgn_bin_reader *reader);
+
+#endif
@@ -3,20 +3,19 @@
 #include "pgn.h"
 #include "chess.h"
 
-#include <assert.h>
 #include <stdbool.h>
-#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
 // Information needed to find a move based on SAN
 struct moveinfo {
-	// passed into generate_moves(), this helps eliminate most legal moves
+	// type, piece, color and target square of the move
 	struct movegenc conf;
 	// promoted piece if any
 	enum piece promo_piece;
-	// disambiguation hint, can be a square, file, or rank.
-	int hint;
+	// squares the piece may come from, narrowed by the disambiguation which
+	// can be a square, file, or rank.
+	u64 from;
 };
 
 static enum piece chrtopiece(const char c)
@@ -46,54 +45,101 @@ static inline int santoi(const char *san)
 	return filetoi(san[0]) + ranktoi(san[1]);
 }
 
-// Extracts from, to, and piece type from a SAN to a movegenc and returns the
-// disambiguation square, rank or file. Disambiguations are needed in cases where
-// two or more pieces can reach the same square. Note special characters like
-// 'x' for caputures or '=', '+', '#' are ignored as we only care about squares
-// here, not note movetype
+static inline bool is_file(const char c)
+{
+	return c >= 'a' && c <= 'h';
+}
+
+static inline bool is_rank(const char c)
+{
+	return c >= '1' && c <= '8';
+}
+
+// Extracts from, to, and piece type from a SAN to a movegenc and sets squares
+// to those the piece can come from, based on the disambiguation. Disambiguations
+// are needed in cases where two or more pieces can reach the same square. Note
+// special characters like 'x' for caputures or '=', '+', '#' are ignored as we
+// only care about squares here, not note movetype. Returns false if the SAN is
+// malformed.
 //
 // QUIET: 	e4, Nf6
 // CAPTURES:	exd4->ed4, Nxf6->Nf6
 // PROMOTIONS:  ed4=Q->ed4
-static int extract_san(const char *from, const char *to, struct movegenc *conf)
+static bool extract_san(const char *from, const char *to, struct movegenc *conf,
+                        u64 *squares)
 {
 	int len = to - from;
-	assert(len >= 0 && len <= 4);
+	bool capture = (conf->type == CAPTURE || conf->type == PROMO_CAPTURE);
 
 	// skip the 'x'
-	if (conf->type == CAPTURE || conf->type == PROMO_CAPTURE)
+	if (capture)
 		++to;
+	if (!is_file(to[0]) || !is_rank(to[1]))
+		return false;
 
 	// first character indicates the piece type, or a pawn if lowercase
 	conf->piece  = chrtopiece(from[0]);
 	conf->target = square_bb(santoi(to));
+	*squares = ~0ULL;
+
+	if (conf->piece == PAWN) {
+		// Pawn moves: e5, d5, these never need disambiguation
+		if (len == 0)
+			return !capture;
+		// pawn captures always give the file: (e)xd4
+		if (len == 1 && is_file(from[0])) {
+			*squares = file(filetoi(from[0]));
+			return true;
+		}
+		return false;
+	}
 
 	switch (len) {
-	// Pawn moves: e5, d5, these never need disambiguation
-	case 0: return -1;
-	// Non-ambiguous moves: (N)f6, (B)g6, (e)xd4
-	case 1: return -1;
+	// Non-ambiguous moves: (N)f6, (B)g6
+	case 1: return true;
 	// Ambiguous moves: (Ng)f6, (R2)f2
 	// These moves require either a rank or file to identify a piece, such
 	// as when two rooks are on the same rank.
-	case 2: return isalpha(from[1]) ? filetoi(from[1]) : ranktoi(from[1]);
+	case 2:
+		if (is_file(from[1]))
+			*squares = file(filetoi(from[1]));
+		else if (is_rank(from[1]))
+			*squares = rank(ranktoi(from[1]));
+		else
+			return false;
+		return true;
 	// Extra Ambiguous moves: (Ng8)f6
 	// Moves which require a square to identify a piece. Not very common.
-	case 3: return santoi(&from[1]);
+	case 3:
+		if (!is_file(from[1]) || !is_rank(from[2]))
+			return false;
+		*squares = square_bb(santoi(&from[1]));
+		return true;
 	}
-	return -1;
+	return false;
 }
 
 // Wrapper for extract_san, handles special cases like castling, promotion and
 // checks/mates.
-// Fills out 'info' with information parsed from text.
-static void get_moveinfo(char *text, enum color color, struct moveinfo *info)
+// Fills out 'info' with information parsed from text, returns false if the
+// text is not a SAN.
+static bool get_moveinfo(char *text, enum color color, struct moveinfo *info)
 {
 	info->conf.color = color;
 	info->conf.type = QUIET;
+	info->promo_piece = PAWN;
+
+	int len = strlen(text);
+	if (len == 0)
+		return false;
+
+	// checks and mates, ignore for now, no usable information
+	char end = text[len - 1];
+	if (end == '+' || end == '#')
+		--len;
 
-	bool short_castle = (strcmp(text, "O-O") == 0);
-	bool long_castle  = (strcmp(text, "O-O-O") == 0);
+	bool short_castle = (len == 3 && strncmp(text, "O-O", len) == 0);
+	bool long_castle  = (len == 5 && strncmp(text, "O-O-O", len) == 0);
 	if (short_castle || long_castle) {
 		info->conf.type    = CASTLE;
 		info->conf.piece   = KING;
@@ -101,87 +147,203 @@ static void get_moveinfo(char *text, enum color color, struct moveinfo *info)
 		// flip sides if black
 		info->conf.target += (color * a8);
 		info->conf.target  = square_bb(info->conf.target);
-		info->hint = -1;
-		return;
+		info->from = ~0ULL;
+		return true;
 	}
 
-	int len = strlen(text);
-
-	// checks and mates, ignore for now, no usable information
-	char end = text[len - 1];
-	if (end == '+' || end == '#')
-		--len;
-
 	// promotions, for example, fxg8(=Q)
 	char *eq_start = strchr(text, '=');
 	if (eq_start) {
+		if (eq_start != &text[len - 2])
+			return false;
 		info->conf.type = PROMOTION;
 		info->promo_piece = chrtopiece(text[len - 1]);
 		len -= 2;
 	}
 
+	// the target square ends the SAN, right after the 'x' of a capture
+	if (len < 2)
+		return false;
 	char *to = &text[len - 2];
 	char *x_start  = strchr(text, 'x');
 	if (x_start) {
+		if (x_start != to - 1)
+			return false;
 		to = x_start;
 		info->conf.type = (eq_start) ? PROMO_CAPTURE : CAPTURE;
 	}
 
-	info->hint = extract_san(text, to, &info->conf);
+	return extract_san(text, to, &info->conf, &info->from);
+}
+
+// pawns which can push to the empty square to, one or two squares
+static u64 pawn_pushers(const struct board *board, int to, enum color color)
+{
+	int behind = to + ((color == WHITE) ? -8 : 8);
+	if (behind < a1 || behind > h8)
+		return 0;
+	if (board->squares[behind] != EMPTY)
+		return square_bb(behind);
+
+	bool double_push = (color == WHITE) ? (to >> 3) == 3 : (to >> 3) == 4;
+	return (double_push) ? square_bb(behind + ((color == WHITE) ? -8 : 8)) : 0;
 }
 
-// Checks if a file, a rank, or both file or rank matches 'from' based on
-// 'disamb', the disambiguation.
-static bool disambiguate(int hint, int from)
+// whether the king of the side making move is safe after it
+static bool leaves_king_safe(const struct board *board, move move)
 {
-	return hint == from
-	    || (hint < 8 && hint == (from & 7))
-	    || hint == (from / 8);
+	enum color color = piece_color(board->squares[move_from(move)]);
+	struct board after;
+	board_make_copy(&after, board, move);
+	return !is_attacked(&after, lsb(pieces(&after, KING, color)), flip_color(color));
 }
 
+// Finds a move starting from its target square. The pieces which can reach it
+// are its attackers, or for pawn pushes the pawns behind it, narrowed down to
+// those matching the SAN. That leaves a single piece unless one of the others
+// is pinned, which SAN does not disambiguate. The candidates are tested for
+// legality and exactly one must be legal, otherwise the SAN is ambiguous.
 static move find_move(struct board *board, struct moveinfo *info)
 {
-	move moves[16];
-	move *last = generate_moves(board, moves, &info->conf);
-	int len = last - moves;
+	struct movegenc *conf = &info->conf;
+	if (conf->type == CASTLE) {
+		move castles[2];
+		move *last = generate_moves(board, castles, conf);
+		return (last > castles) ? castles[0] : 0;
+	}
 
-	if (len == 1)
-		return moves[0];
+	int to = lsb(conf->target);
+	enum color color = conf->color;
+	bool capture = (conf->type == CAPTURE || conf->type == PROMO_CAPTURE);
+	bool promotion = (conf->type == PROMOTION || conf->type == PROMO_CAPTURE);
+	bool enpassant = capture && conf->piece == PAWN && to == board->ep_square;
 
-	for (int i = 0; i < len; ++i) {
-		move move = moves[i];
-		// Multiple promotion moves, but we already have the piece we
-		// want so set it manually and return early
-		if (move_is_promotion(move)) {
-			move_set_promo_piece(move, info->promo_piece - 1);
-			return move;
-		}
-		if (disambiguate(info->hint, move_from(move)))
-			return move;
+	// captures need an enemy piece on the target square, other moves an
+	// empty one, and pawns promote exactly when reaching the last rank
+	bool last_rank = (to >> 3) == ((color == WHITE) ? 7 : 0);
+	if ((enpassant) ? board->squares[to] != EMPTY
+	                : capture != ((board->colors[flip_color(color)] & conf->target) != 0))
+		return 0;
+	if (conf->piece == PAWN && promotion != last_rank)
+		return 0;
+	if (promotion && (info->promo_piece == PAWN || info->promo_piece == KING))
+		return 0;
+	if (board->colors[color] & conf->target)
+		return 0;
+
+	u64 candidates = pieces(board, conf->piece, color) & info->from;
+	if (conf->piece == PAWN && !capture)
+		candidates &= pawn_pushers(board, to, color);
+	else
+		candidates &= attackers_to(board, to, board->pieces[ALL]);
+
+	move found = 0;
+	while (candidates) {
+		int from = pop_lsb(&candidates);
+		move move;
+		if (promotion)
+			move = make_promotion(from, to, capture, info->promo_piece - 1);
+		else if (enpassant)
+			move = make_enpassant(from, to);
+		else
+			move = make_move(from, to, capture, false, 0);
+
+		if (!leaves_king_safe(board, move))
+			continue;
+		if (found)
+			return 0;
+		found = move;
 	}
-	return 0;
+	return found;
 }
 
-int pgn_to_moves(const struct pgn *pgn, move *moves)
+// Resolves a SAN and makes the move on board. A check or mate marker must
+// match the position after the move, unmarked checks are accepted.
+// Returns 0 if the move is not possible.
+static move play_san(struct board *board, char *text, enum color color)
+{
+	struct moveinfo info;
+	if (!get_moveinfo(text, color, &info))
+		return 0;
+	move move = find_move(board, &info);
+	if (!move)
+		return 0;
+
+	// a check marker must be right, tried on a copy so that the board is
+	// left as it was if not
+	char end = text[strlen(text) - 1];
+	if (end == '+' || end == '#') {
+		struct board after;
+		board_make_copy(&after, board, move);
+		u64 king = pieces(&after, KING, flip_color(color));
+		if (king && !is_attacked(&after, lsb(king), color))
+			return 0;
+	}
+
+	board_move(board, move);
+	return move;
+}
+
+// state of pgn_next_game_moves() while the game is being parsed
+struct resolver {
+	struct board board;
+	struct pgn_movelist *moves;
+	bool failed;
+};
+
+static bool resolve_move(void *data, const char *san, int len)
 {
-	if (!attacks_table_initilized())
-		init_lineattacks_table();
+	struct resolver *resolver = data;
+	// the moves following one which could not be resolved are nonsense
+	if (resolver->failed)
+		return true;
+
+	char text[8];
+	if (len >= (int) sizeof(text)) {
+		resolver->failed = true;
+		return false;
+	}
+	memcpy(text, san, len);
+	text[len] = '\0';
+
+	enum color color = (resolver->moves->count & 1);
+	move move = play_san(&resolver->board, text, color);
+	if (!move) {
+		resolver->failed = true;
+		return false;
+	}
 
+	pgn_movelist_push(resolver->moves, move);
+	return true;
+}
+
+enum pgn_result pgn_next_game_moves(struct pgn_reader *reader, struct pgn *pgn,
+                                    struct pgn_movelist *moves)
+{
+	struct resolver resolver = { .moves = moves };
+	board_init(&resolver.board);
+	moves->count = 0;
+
+	pgn_set_move_handler(reader, resolve_move, &resolver);
+	enum pgn_result result = pgn_next_game(reader, pgn);
+	pgn_set_move_handler(reader, NULL, NULL);
+	return result;
+}
+
+int pgn_to_moves(const struct pgn *pgn, move *moves)
+{
 	int n = 0;
 	struct board board;
 	board_init(&board);
 
-	struct moveinfo info;
 	for (int i = 0; i < pgn->movecount; ++i) {
 		// white moves are even and black moves are odd, 0-based index
 		enum color color = (i & 1);
-		get_moveinfo(pgn->moves[i].text, color, &info);
-		move move = find_move(&board, &info);
+		move move = play_san(&board, pgn->moves[i].text, color);
 
 		if (move) {
 			++n;
 			moves[i] = move;
-			board_move(&board, move);
 		} else {
 			// no point in continuing, the rest of the moves will
 			// just be nonsense
@@ -190,3 +352,20 @@ int pgn_to_moves(const struct pgn *pgn, move *moves)
 	}
 	return n;
 }
+
+void pgn_movelist_push(struct pgn_movelist *list, move move)
+{
+	if (list->count == list->size) {
+		list->size = (list->size) ? list->size * 2 : 256;
+		list->moves = realloc(list->moves, list->size * sizeof(*list->moves));
+		if (list->moves == NULL)
+			abort();
+	}
+	list->moves[list->count++] = move;
+}
+
+void pgn_movelist_free(struct pgn_movelist *list)
+{
+	free(list->moves);
+	*list = (struct pgn_movelist) {0};
+}
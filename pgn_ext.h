@@ -4,9 +4,27 @@
 #include "pgn.h"
 #include "chess.h"
 
+// Moves of a game, grows as needed. Must be zeroed before its first use.
+struct pgn_movelist {
+	move *moves;
+	int count;
+	int size;
+};
+
+// Appends a move to list.
+void pgn_movelist_push(struct pgn_movelist *list, move move);
+void pgn_movelist_free(struct pgn_movelist *list);
+
 // Converts a list of "struct pgn_move" to a list of "struct move", "moves"
 // must be large enough! (>= pgn_moves.len).
 // Returns the number of moves filled.
 int pgn_to_moves(const struct pgn *pgn, move *moves);
 
+// Reads the next game like pgn_next_game(), but resolves every move against
+// the board as soon as it is parsed, so pgn only gets the tags and the moves
+// go to moves. Resolving stops at the first move which is not possible, which
+// is a PGN_MOVE_PARSE_ERROR.
+enum pgn_result pgn_next_game_moves(struct pgn_reader *reader, struct pgn *pgn,
+                                    struct pgn_movelist *moves);
+
 #endif
@@ -0,0 +1,254 @@
+#include "pgn_index.h"
+
+#include "pgn.h"
+#include "pgn_internal.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The index is stored exactly as it is kept in memory: a header, an entry for
+// every game and then the tag values the entries point to. Loading it is a
+// single mmap and finding a game is an array lookup.
+#define INDEX_MAGIC "PGNIDX1\n"
+
+struct index_header {
+	char magic[8];
+	uint64_t filesize;	// size and modification time of the indexed
+	int64_t mtime;		// file, the index is rebuilt if they change
+	uint64_t count;		// number of games
+	uint64_t strings;	// size of the tag values
+};
+
+struct index_entry {
+	uint64_t offset;	// location of the game in the file
+	uint32_t length;
+	uint32_t tags[PGN_INDEX_TAG_MAX]; // offsets of the tag values
+};
+
+struct pgn_index {
+	char *data;	// header, entries and tag values
+	size_t size;
+	bool mapped;
+
+	const struct index_header *header;
+	const struct index_entry *entries;
+	const char *strings;
+};
+
+static const int tag_atoms[PGN_INDEX_TAG_MAX] = {
+	[PGN_INDEX_EVENT]  = PGN_TAG_EVENT,
+	[PGN_INDEX_DATE]   = PGN_TAG_DATE,
+	[PGN_INDEX_WHITE]  = PGN_TAG_WHITE,
+	[PGN_INDEX_BLACK]  = PGN_TAG_BLACK,
+	[PGN_INDEX_RESULT] = PGN_TAG_RESULT,
+};
+
+static void set_pointers(struct pgn_index *index)
+{
+	index->header  = (const struct index_header *) index->data;
+	index->entries = (const struct index_entry *) (index->header + 1);
+	index->strings = (const char *) (index->entries + index->header->count);
+}
+
+// whether the tag values are null terminated and every entry points into them
+static bool strings_valid(const struct pgn_index *index)
+{
+	uint64_t len = index->header->strings;
+	if (len == 0 || index->strings[len - 1] != '\0')
+		return false;
+
+	for (uint64_t i = 0; i < index->header->count; ++i) {
+		for (int tag = 0; tag < PGN_INDEX_TAG_MAX; ++tag) {
+			if (index->entries[i].tags[tag] >= len)
+				return false;
+		}
+	}
+	return true;
+}
+
+static bool load_index(struct pgn_index *index, const char *path, const struct stat *st)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat idx;
+	if (fstat(fd, &idx) != 0 || idx.st_size < (off_t) sizeof(struct index_header)) {
+		close(fd);
+		return false;
+	}
+
+	void *map = mmap(NULL, idx.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+
+	const struct index_header *header = map;
+	size_t size = idx.st_size - sizeof(*header);
+	bool valid = memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) == 0
+		&& header->filesize == (uint64_t) st->st_size
+		&& header->mtime == (int64_t) st->st_mtime
+		&& header->count <= size / sizeof(struct index_entry)
+		&& header->strings == size - header->count * sizeof(struct index_entry);
+	if (valid) {
+		index->data = map;
+		set_pointers(index);
+		valid = strings_valid(index);
+	}
+	if (!valid) {
+		munmap(map, idx.st_size);
+		return false;
+	}
+
+	index->size = idx.st_size;
+	index->mapped = true;
+	return true;
+}
+
+static bool build_index(struct pgn_index *index, const char *filename, const struct stat *st)
+{
+	struct pgn_reader *reader = pgn_open(filename, PGN_HEADERS_ONLY);
+	if (reader == NULL)
+		return false;
+
+	struct index_entry *entries = NULL;
+	size_t count = 0, entries_size = 0;
+	// offset 0 is the empty string, used for missing tags
+	char *strings = NULL;
+	size_t len = 1, strings_size = 0;
+	strings = pgn_grow(strings, &strings_size, len, 1);
+	strings[0] = '\0';
+
+	struct pgn pgn = {0};
+	while (pgn_next_game(reader, &pgn) != PGN_EOF) {
+		entries = pgn_grow(entries, &entries_size, count + 1, sizeof(*entries));
+		struct index_entry *entry = &entries[count++];
+		*entry = (struct index_entry) {
+			.offset = pgn.offset,
+			.length = pgn.length,
+		};
+
+		for (int i = 0; i < pgn.tagcount; ++i) {
+			for (int tag = 0; tag < PGN_INDEX_TAG_MAX; ++tag) {
+				if (pgn.tags[i].atom != tag_atoms[tag])
+					continue;
+
+				size_t n = strlen(pgn.tags[i].desc) + 1;
+				strings = pgn_grow(strings, &strings_size, len + n, 1);
+				memcpy(strings + len, pgn.tags[i].desc, n);
+				entry->tags[tag] = len;
+				len += n;
+			}
+		}
+	}
+	pgn_free(&pgn);
+	pgn_close(reader);
+
+	struct index_header header = {
+		.magic = INDEX_MAGIC,
+		.filesize = st->st_size,
+		.mtime = st->st_mtime,
+		.count = count,
+		.strings = len,
+	};
+
+	index->size = sizeof(header) + count * sizeof(*entries) + len;
+	index->data = malloc(index->size);
+	if (index->data == NULL)
+		abort();
+
+	char *p = index->data;
+	memcpy(p, &header, sizeof(header));
+	p += sizeof(header);
+	if (count)
+		memcpy(p, entries, count * sizeof(*entries));
+	p += count * sizeof(*entries);
+	memcpy(p, strings, len);
+
+	free(entries);
+	free(strings);
+	return true;
+}
+
+// the index is written to a temporary file first, so a reader never sees a
+// partially written index
+static void save_index(const struct pgn_index *index, const char *path)
+{
+	char tmp[4096];
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int) sizeof(tmp))
+		return;
+
+	FILE *file = fopen(tmp, "wb");
+	if (file == NULL)
+		return;
+
+	bool ok = fwrite(index->data, 1, index->size, file) == index->size;
+	ok &= (fclose(file) == 0);
+	if (!ok || rename(tmp, path) != 0)
+		remove(tmp);
+}
+
+struct pgn_index *pgn_index_open(const char *filename)
+{
+	struct stat st;
+	if (stat(filename, &st) != 0 || !S_ISREG(st.st_mode))
+		return NULL;
+
+	char path[4096];
+	if (snprintf(path, sizeof(path), "%s.idx", filename) >= (int) sizeof(path))
+		return NULL;
+
+	struct pgn_index *index = calloc(1, sizeof(*index));
+	if (index == NULL)
+		abort();
+
+	if (!load_index(index, path, &st)) {
+		if (!build_index(index, filename, &st)) {
+			free(index);
+			return NULL;
+		}
+		save_index(index, path);
+	}
+
+	set_pointers(index);
+	return index;
+}
+
+void pgn_index_close(struct pgn_index *index)
+{
+	if (index->mapped)
+		munmap(index->data, index->size);
+	else
+		free(index->data);
+	free(index);
+}
+
+int pgn_index_count(const struct pgn_index *index)
+{
+	return index->header->count;
+}
+
+const char *pgn_index_tag(const struct pgn_index *index, int n, enum pgn_index_tag tag)
+{
+	return index->strings + index->entries[n].tags[tag];
+}
+
+enum pgn_result pgn_index_read(const struct pgn_index *index, int n,
+                               struct pgn_reader *reader, struct pgn *pgn)
+{
+	if (n < 0 || n >= pgn_index_count(index))
+		return PGN_EOF;
+
+	enum pgn_result result = pgn_seek(reader, index->entries[n].offset);
+	if (result != PGN_OK)
+		return result;
+
+	return pgn_next_game(reader, pgn);
+}
@@ -0,0 +1,35 @@
+#ifndef PGN_INDEX_H
+#define PGN_INDEX_H
+
+#include "pgn.h"
+
+// Index of the games in a pgn file, saved next to it as "<filename>.idx".
+// It records where each game is in the file along with a few of its tags, so
+// any game can be read without parsing the games before it.
+
+enum pgn_index_tag {
+	PGN_INDEX_EVENT,
+	PGN_INDEX_DATE,
+	PGN_INDEX_WHITE,
+	PGN_INDEX_BLACK,
+	PGN_INDEX_RESULT,
+	PGN_INDEX_TAG_MAX
+};
+
+struct pgn_index;
+
+// Loads the index of a file, building and saving it first if it is missing or
+// older than the file. If it cannot be saved the index is only kept in memory.
+// Returns NULL if the file could not be read or is not a regular file.
+struct pgn_index *pgn_index_open(const char *filename);
+void pgn_index_close(struct pgn_index *index);
+
+int pgn_index_count(const struct pgn_index *index);
+// Value of one of the indexed tags of game n, "" if the game does not have it.
+const char *pgn_index_tag(const struct pgn_index *index, int n, enum pgn_index_tag tag);
+// Reads game n of the indexed file with a reader opened on the same file, see
+// pgn_next_game(). Returns PGN_EOF if there is no such game.
+enum pgn_result pgn_index_read(const struct pgn_index *index, int n,
+                               struct pgn_reader *reader, struct pgn *pgn);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef PGN_INTERNAL_H
+#define PGN_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Helpers shared by the pgn modules, not part of the library interface.
+
+// FNV-1a
+static inline uint32_t pgn_hash(const char *data, size_t len)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < len; ++i)
+		hash = (hash ^ (unsigned char) data[i]) * 16777619u;
+	return hash;
+}
+
+// Grows a malloc'd buffer of *size elements so that it holds at least need
+// elements, doubling its size. Returns the possibly moved buffer.
+void* pgn_grow(void *buffer, size_t *size, size_t need, size_t element_size);
+
+#endif
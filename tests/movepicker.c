@@ -0,0 +1,135 @@
+#include "../pgn.h"
+#include "../pgn_ext.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int compare_moves(const void *a, const void *b)
+{
+	return *(const move *) a - *(const move *) b;
+}
+
+// whether the picker yields the legal moves of the position, noisy moves first,
+// and count_legal_moves() counts them
+static bool check_position(struct board *board, enum color color)
+{
+	move legal[MAX_MOVES], picked[MAX_MOVES];
+	int count = generate_legal_moves(board, legal, color) - legal;
+	if (count_legal_moves(board) != count)
+		return false;
+
+	struct movepicker picker;
+	movepicker_init(&picker, board, color);
+	int n = 0;
+	bool quiets = false;
+	for (move m; (m = movepicker_next(&picker)); ) {
+		if (n == count || (quiets && !move_is_quiet(m)))
+			return false;
+		quiets |= move_is_quiet(m);
+		picked[n++] = m;
+	}
+
+	if (n != count)
+		return false;
+	qsort(legal, count, sizeof(*legal), compare_moves);
+	qsort(picked, n, sizeof(*picked), compare_moves);
+	for (int i = 0; i < count; ++i)
+		if (legal[i] != picked[i])
+			return false;
+	return true;
+}
+
+static bool same_position(const struct board *a, const struct board *b)
+{
+	return memcmp(a->pieces, b->pieces, sizeof(a->pieces)) == 0
+	    && memcmp(a->colors, b->colors, sizeof(a->colors)) == 0
+	    && memcmp(a->squares, b->squares, sizeof(a->squares)) == 0
+	    && a->castling == b->castling && a->ep_square == b->ep_square
+	    && a->side == b->side && a->halfmove == b->halfmove && a->key == b->key;
+}
+
+// whether every legal move made with board_move() gives the same position as
+// board_make_copy(), and undoing it the position before, with the incremental
+// keys equal to board_compute_key()
+static bool check_make_undo(struct board *board, enum color color)
+{
+	move legal[MAX_MOVES];
+	move *last = generate_legal_moves(board, legal, color);
+	struct board before = *board;
+	if (board->key != board_compute_key(board))
+		return false;
+
+	for (move *m = legal; m < last; ++m) {
+		struct board copy;
+		board_make_copy(&copy, board, *m);
+		board_move(board, *m);
+		bool same = same_position(board, &copy)
+		         && board->key == board_compute_key(board);
+		board_undo_move(board, *m);
+		if (!same || !same_position(board, &before))
+			return false;
+	}
+	return true;
+}
+
+// whether 1. Nf3 Nf6 2. e4 and 1. e4 Nf6 2. Nf3 hash the same, the en passant
+// square of the first no pawn can capture on
+static bool check_transposition(void)
+{
+	struct board a, b;
+	board_init(&a);
+	board_init(&b);
+	move first[]  = { make_quiet(g1, f3), make_quiet(g8, f6), make_quiet(e2, e4) };
+	move second[] = { make_quiet(e2, e4), make_quiet(g8, f6), make_quiet(g1, f3) };
+	for (int i = 0; i < 3; ++i) {
+		board_move(&a, first[i]);
+		board_move(&b, second[i]);
+	}
+	return a.key == b.key && a.key == board_compute_key(&a);
+}
+
+// Compares the moves of a movepicker and the count of count_legal_moves() with
+// generate_legal_moves(), and make/undo with copy-make and the keys with
+// board_compute_key(), in every position of the games of a pgn file.
+int main(int argc, char **argv)
+{
+	if (argc != 2) {
+		fprintf(stderr, "usage: movepicker file.pgn\n");
+		return 1;
+	}
+
+	struct pgn_reader *reader = pgn_open(argv[1], 0);
+	if (reader == NULL)
+		return 1;
+
+	struct pgn pgn = {0};
+	struct pgn_movelist moves = {0};
+	static struct history history;
+	int failed = 0;
+	if (!check_transposition()) {
+		printf("transposition keys differ\n");
+		++failed;
+	}
+	for (int game = 1; pgn_next_game_moves(reader, &pgn, &moves) != PGN_EOF; ++game) {
+		struct board board;
+		board_init(&board);
+		board_set_history(&board, &history);
+		for (int i = 0; i <= moves.count; ++i) {
+			if (!check_position(&board, i & 1)) {
+				printf("game %d ply %d: moves differ\n", game, i);
+				++failed;
+			}
+			if (!check_make_undo(&board, i & 1)) {
+				printf("game %d ply %d: make and undo differ\n", game, i);
+				++failed;
+			}
+			if (i < moves.count)
+				board_move(&board, moves.moves[i]);
+		}
+	}
+	pgn_movelist_free(&moves);
+	pgn_free(&pgn);
+	pgn_close(reader);
+	return failed != 0;
+}
@@ -1,39 +1,106 @@
 #include "../chess.h"
 
+#include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-static struct board board;
-static enum color color = WHITE;
-
-u64 perft(int depth)
+// Sets up board from the fields of a FEN up to the halfmove clock, the move
+// number is not kept. Returns false if the FEN is malformed.
+static bool load_fen(struct board *board, const char *fen)
 {
-	if (depth == 0)
-		return 1ULL;
+	static const char pieces[] = "PNBRQKpnbrqk";
+
+	memset(board, 0, sizeof(*board));
+	memset(board->squares, EMPTY, sizeof(board->squares));
 
-	u64 nodes = 0;
+	int rank = 7, file = 0;
+	for (; *fen && *fen != ' '; ++fen) {
+		const char *piece = strchr(pieces, *fen);
+		if (*fen == '/') {
+			--rank;
+			file = 0;
+		} else if (isdigit((unsigned char) *fen)) {
+			file += *fen - '0';
+		} else if (piece && rank >= 0 && file < 8) {
+			board_put_piece(board, rank * 8 + file++, piece - pieces);
+		} else {
+			return false;
+		}
+	}
 
-	move moves[256];
-	move *last = generate_legal_moves(&board, moves, color);
-	color = flip_color(color);
-	int n_moves = last - moves;
+	char side, castling[5], ep[3];
+	int halfmove = 0;
+	if (sscanf(fen, " %c %4s %2s %d", &side, castling, ep, &halfmove) < 3)
+		return false;
 
-	for (int i = 0; i < n_moves; ++i) {
-		enum piece_id captured_piece = board.squares[move_to(moves[i])];
-		board_move(&board, moves[i]);
-		nodes += perft(depth - 1);
-		board_undo_move(&board, moves[i], captured_piece);
+	board->side = (side == 'b') ? BLACK : WHITE;
+	for (char *c = castling; *c; ++c) {
+		switch (*c) {
+		case 'K': board->castling |= WHITE_KINGSIDE;  break;
+		case 'Q': board->castling |= WHITE_QUEENSIDE; break;
+		case 'k': board->castling |= BLACK_KINGSIDE;  break;
+		case 'q': board->castling |= BLACK_QUEENSIDE; break;
+		}
 	}
-	return nodes;
+	board->ep_square = (ep[0] == '-') ? SQUARES_NONE : (ep[0] - 'a') + (ep[1] - '1') * 8;
+	board->halfmove = halfmove;
+	board->key = board_compute_key(board);
+	return true;
 }
 
-int
-main(int argc, char **argv)
+// prints move the way other engines do, castles as the king's move and
+// promotions with the piece
+static void print_move(move move)
 {
-	int depth = strtol(argv[1], NULL, 10);
+	int from = move_from(move), to = move_to(move);
+	if (move_is_castle(move))
+		to = from + ((to > from) ? 2 : -2);
+
+	printf("%c%d%c%d", 'a' + from % 8, 1 + from / 8, 'a' + to % 8, 1 + to / 8);
+	if (move_is_promotion(move))
+		putchar("nbrq"[move_promo_piece(move)]);
+}
+
+// Prints the perft count of the initial position or of the one given as a FEN,
+// with -d the count below every move first.
+int main(int argc, char **argv)
+{
+	bool divide = argc > 1 && strcmp(argv[1], "-d") == 0;
+	if (argc != 2 + divide && argc != 3 + divide) {
+		fprintf(stderr, "usage: perft [-d] depth [fen]\n");
+		return 1;
+	}
+
+	char *end;
+	long depth = strtol(argv[1 + divide], &end, 10);
+	if (end == argv[1 + divide] || *end != '\0' || depth < 0) {
+		fprintf(stderr, "invalid depth: %s\n", argv[1 + divide]);
+		return 1;
+	}
+
+	struct board board;
 	board_init(&board);
-	init_lineattacks_table();
-	u64 nodes = perft(depth);
-	printf("%llu\n", nodes);
-	return 1;
+	if (argc == 3 + divide && !load_fen(&board, argv[2 + divide])) {
+		fprintf(stderr, "invalid fen: %s\n", argv[2 + divide]);
+		return 1;
+	}
+
+	if (!divide) {
+		printf("%llu\n", perft(&board, depth));
+		return 0;
+	}
+
+	move moves[MAX_MOVES];
+	u64 nodes[MAX_MOVES];
+	int count = perft_divide(&board, depth, moves, nodes);
+
+	u64 total = 0;
+	for (int i = 0; i < count; ++i) {
+		print_move(moves[i]);
+		printf(": %llu\n", nodes[i]);
+		total += nodes[i];
+	}
+	printf("\n%llu\n", total);
+	return 0;
 }
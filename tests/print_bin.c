@@ -0,0 +1,82 @@
+#include "../pgn.h"
+#include "../pgn_ext.h"
+#include "../pgn_bin.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_game(const struct pgn *pgn, const move *moves, int count)
+{
+	for (int i = 0; i < pgn->tagcount; ++i)
+		printf("%s \"%s\"\n", pgn->tags[i].name, pgn->tags[i].desc);
+
+	printf("%d:", count);
+	for (int i = 0; i < count; ++i) {
+		int from = move_from(moves[i]), to = move_to(moves[i]);
+		printf(" %c%d%c%d", 'a' + from % 8, 1 + from / 8, 'a' + to % 8, 1 + to / 8);
+	}
+	printf("\n");
+}
+
+// Prints the tags and moves of every game of a pgn file, after converting it
+// to a binary file and reading that back. With -p the games are printed as
+// read from the pgn file instead, with -s too but resolving moves while
+// parsing.
+int main(int argc, char **argv)
+{
+	bool direct = argc > 1 && strcmp(argv[1], "-p") == 0;
+	bool single = argc > 1 && strcmp(argv[1], "-s") == 0;
+	if (argc != 3) {
+		fprintf(stderr, "usage: print_bin file.pgn out.bin | -p|-s file.pgn\n");
+		return 1;
+	}
+
+	struct pgn pgn = {0};
+	struct pgn_movelist moves = {0};
+	if (single) {
+		struct pgn_reader *reader = pgn_open(argv[2], 0);
+		if (reader == NULL)
+			return 1;
+		while (pgn_next_game_moves(reader, &pgn, &moves) != PGN_EOF)
+			print_game(&pgn, moves.moves, moves.count);
+		pgn_movelist_free(&moves);
+		pgn_free(&pgn);
+		pgn_close(reader);
+		return 0;
+	}
+
+	const char *filename = argv[direct ? 2 : 1];
+	struct pgn_reader *reader = pgn_open(filename, 0);
+	struct pgn_bin_writer *writer = direct ? NULL : pgn_bin_create(argv[2]);
+	if (reader == NULL || (!direct && writer == NULL))
+		return 1;
+
+	while (pgn_next_game(reader, &pgn) != PGN_EOF) {
+		move *moves = malloc((pgn.movecount + 1) * sizeof(*moves));
+		int count = pgn_to_moves(&pgn, moves);
+		if (direct)
+			print_game(&pgn, moves, count);
+		else
+			pgn_bin_write(writer, &pgn, moves, count);
+		free(moves);
+	}
+	pgn_close(reader);
+	if (direct) {
+		pgn_free(&pgn);
+		return 0;
+	}
+	if (pgn_bin_finish(writer) != PGN_OK)
+		return 1;
+
+	struct pgn_bin_reader *bin = pgn_bin_open(argv[2]);
+	if (bin == NULL)
+		return 1;
+	while (pgn_bin_next_game(bin, &pgn, &moves) == PGN_OK)
+		print_game(&pgn, moves.moves, moves.count);
+
+	pgn_movelist_free(&moves);
+	pgn_free(&pgn);
+	pgn_bin_close(bin);
+	return 0;
+}
@@ -0,0 +1,47 @@
+#include "../pgn.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_game(struct pgn *pgn)
+{
+	printf("%d %d:", pgn->tagcount, pgn->movecount);
+	for (int i = 0; i < pgn->movecount; ++i)
+		printf(" %s", pgn->moves[i].text);
+	printf("\n");
+}
+
+// Prints every game of a file, read one by one or, if a thread count is
+// given, all at once with pgn_read_all(). With -h only headers are read.
+int main(int argc, char **argv)
+{
+	int flags = 0;
+	if (argc > 1 && strcmp(argv[1], "-h") == 0) {
+		flags = PGN_HEADERS_ONLY;
+		++argv;
+		--argc;
+	}
+
+	if (argc > 2) {
+		struct pgn *games;
+		int count;
+		pgn_read_all(argv[1], flags, strtol(argv[2], NULL, 10), &games, &count);
+		for (int i = 0; i < count; ++i) {
+			print_game(&games[i]);
+			pgn_free(&games[i]);
+		}
+		free(games);
+		return 0;
+	}
+
+	struct pgn pgn = {0};
+	struct pgn_reader *reader = pgn_open(argv[1], flags);
+
+	while (pgn_next_game(reader, &pgn) != PGN_EOF)
+		print_game(&pgn);
+	pgn_free(&pgn);
+
+	pgn_close(reader);
+	return 0;
+}
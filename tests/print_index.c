@@ -0,0 +1,44 @@
+#include "../pgn.h"
+#include "../pgn_index.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Prints the number of games in a file and the indexed tags and moves of
+// game n, read through the index.
+int main(int argc, char **argv)
+{
+	if (argc != 3) {
+		fprintf(stderr, "usage: print_index file.pgn n\n");
+		return 1;
+	}
+
+	struct pgn_index *index = pgn_index_open(argv[1]);
+	if (index == NULL) {
+		fprintf(stderr, "cannot index %s\n", argv[1]);
+		return 1;
+	}
+	int n = strtol(argv[2], NULL, 10);
+
+	printf("%d\n", pgn_index_count(index));
+	if (n < 0 || n >= pgn_index_count(index)) {
+		pgn_index_close(index);
+		return 1;
+	}
+	for (int tag = 0; tag < PGN_INDEX_TAG_MAX; ++tag)
+		printf("%s\n", pgn_index_tag(index, n, tag));
+
+	struct pgn pgn = {0};
+	struct pgn_reader *reader = pgn_open(argv[1], 0);
+	pgn_index_read(index, n, reader, &pgn);
+
+	printf("%d %d:", pgn.tagcount, pgn.movecount);
+	for (int i = 0; i < pgn.movecount; ++i)
+		printf(" %s", pgn.moves[i].text);
+	printf("\n");
+
+	pgn_free(&pgn);
+	pgn_close(reader);
+	pgn_index_close(index);
+	return 0;
+}
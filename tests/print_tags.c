@@ -1,14 +1,33 @@
 #include "../pgn.h"
 
 #include <stdio.h>
+#include <string.h>
 
+// Prints the values of all tags, or only of the tags named after the file.
+// With -a the atoms of the names are looked up before the file is read.
 int main(int argc, char **argv)
 {
+	bool atoms = argc > 1 && strcmp(argv[1], "-a") == 0;
+	argv += atoms;
+	argc -= atoms;
+
+	int atom[argc];
+	for (int i = 2; atoms && i < argc; ++i)
+		atom[i] = pgn_tag_atom(argv[i]);
+
 	struct pgn pgn;
 	pgn_read(&pgn, argv[1]);
 
-	for (int i = 0; i < pgn.tagcount; ++i)
-		printf("%s\n", pgn.tags[i].desc);
+	if (argc > 2) {
+		for (int i = 2; i < argc; ++i) {
+			const char *desc = (atoms) ? pgn_get_tag_atom(&pgn, atom[i])
+			                           : pgn_get_tag(&pgn, argv[i]);
+			printf("%s\n", (desc) ? desc : "(none)");
+		}
+	} else {
+		for (int i = 0; i < pgn.tagcount; ++i)
+			printf("%s\n", pgn.tags[i].desc);
+	}
 
 	pgn_free(&pgn);
 }
@@ -0,0 +1,249 @@
+// Generated by gentables.c, do not edit.
+
+static const u64 zobrist_pieces[EMPTY][64] = {
+	{
+		0xd83b3e29a21487aULL, 0x54c44c79f1fe9d67ULL, 0xa845f342007a0e78ULL, 0x7d6e0b878a794779ULL,
+		0x90d8d6e5a10dd485ULL, 0x9de6cf0f6d5a586eULL, 0xd566404840a2ab9dULL, 0x674bfece098c4828ULL,
+		0x87d6e3d2afc200acULL, 0xd2f57ac518cbb99dULL, 0x2a74b4aeb82db2ULL, 0xbc858f30d87296d1ULL,
+		0x26d141d7b47a58a8ULL, 0xec0202237faa74fdULL, 0x13404cd3e565dfa1ULL, 0x54b07c175848b28dULL,
+		0x25072963263f0842ULL, 0x2ecc50074cccf5fULL, 0xdacd1f060d908a3dULL, 0x3c9ae8905bd77ae6ULL,
+		0x9f7bc7db18d2566cULL, 0xac76aeb5a047dbc6ULL, 0xb71eb0ae33b29f39ULL, 0x3df20c533dcc306cULL,
+		0xabcdbaa682de9209ULL, 0x6786d31b243ac0a4ULL, 0x849d9d80831e02d9ULL, 0xe2c9ab92ef636718ULL,
+		0x296f3277cfd51acULL, 0xbe60e507909c1fdULL, 0x7956b9155ffd2adbULL, 0x88a5489881b0e754ULL,
+		0xc99e7d7a6b1d3ccdULL, 0xdb292f12f361b02ULL, 0xe7e8d30a316965cfULL, 0x88048db0941040fbULL,
+		0x1d1bbc9e745ed9c7ULL, 0x22717eef126d3a5aULL, 0x834bc6881be7bfc5ULL, 0x1301453fc472f3f7ULL,
+		0x24a212adf6cfeee2ULL, 0xeef2fc479582dad0ULL, 0x7bb62743d4a82368ULL, 0xe7b4ef83dc7c569aULL,
+		0x1c97d6c17a1ce09bULL, 0xaeb34774571e0746ULL, 0x8daca89158b251f3ULL, 0xfaff30d01d4b1980ULL,
+		0xec4798f19082ab12ULL, 0xe5215db40ab9ce72ULL, 0xc3e9ce5aedcece77ULL, 0x49d1dcfb32d131edULL,
+		0x918e9e3e333146e3ULL, 0x50d51696787f55b4ULL, 0xaa58a03be88d5002ULL, 0xda37a1fd3c69febcULL,
+		0x22fb986fba1247f5ULL, 0x2cd822cec6864769ULL, 0x2f8b786e4ea0081eULL, 0x993065d78ea4114dULL,
+		0x2b4bbec88b15fc32ULL, 0xf5e013034672ad9eULL, 0x9c29a128fd9ef57cULL, 0x1636f8e20698e92dULL,
+	},
+	{
+		0xf45a4999063c350fULL, 0x16513f36f7cb2f45ULL, 0x20ce772c97ad0958ULL, 0x8e8c2e8e1c50c30aULL,
+		0x8f90bc11de2c3b28ULL, 0x1d9cd265caf9aaaeULL, 0x85e846dd95161004ULL, 0xcba1c108a6de41c7ULL,
+		0x1a5c7d55f70f690cULL, 0xdf299a6336a13a58ULL, 0xb51970ad741828d5ULL, 0x2150ff5e05151306ULL,
+		0x8e9e171e8959989eULL, 0xc1560fa6a2c6a718ULL, 0x401f06c6c16c1346ULL, 0x22cb9be13e9f2b4bULL,
+		0xdb6e9abf1bd51537ULL, 0x59ce4401bed86164ULL, 0x23a0bd555b58c420ULL, 0xfd6402dde56b1fd6ULL,
+		0xf03b990bf89bd645ULL, 0x607e3cd84c201de6ULL, 0x4ef15de9ff656da2ULL, 0xd527a619652f472fULL,
+		0x22ff9cd34b252992ULL, 0xf7a4199ab0018f9ULL, 0x789c99b9b7104bfcULL, 0x47e5413ef331597ULL,
+		0x31e064e2ba08761bULL, 0xf2a4cdf6b08ccfacULL, 0xf9bb2c6aa3b74b51ULL, 0x6e649be9309a7aadULL,
+		0x788ba774a28d717dULL, 0x3b786508b3474f50ULL, 0x7a92aca2442cc9afULL, 0xf3d9de53f6ef4b2ULL,
+		0x2983ceb87bd3bfa0ULL, 0x81c12d1d5e35716dULL, 0xa9490f9724be51efULL, 0x90c066ce32f7b0fULL,
+		0x6736980b063d46fcULL, 0x22b6f7ba6874f40eULL, 0x13aefbb6611d895eULL, 0x8f253558e6843a7aULL,
+		0x51ebb86d8d0c734dULL, 0x90180edcff467a55ULL, 0x4427a2d1faf915eULL, 0xd4867309eefba770ULL,
+		0x1aea2e225b7214bcULL, 0x2e50398765648c31ULL, 0x76431f96f583c75bULL, 0x280033594d19939eULL,
+		0x58190ce2c2414047ULL, 0x1327051beb2689c5ULL, 0xb3144734100136cdULL, 0x4f7a4d14869444ceULL,
+		0xed9e20549b1b7b78ULL, 0xc5ee11ec791b3496ULL, 0x9947308e5eedffefULL, 0x316c9690ee0c70d1ULL,
+		0x7fea0e38a55133a5ULL, 0xc0dc7fe4035c2a04ULL, 0x24fc0c1bf156a11bULL, 0xa572c6b5864ba0d0ULL,
+	},
+	{
+		0x88db05ebfddc3595ULL, 0xbc67a3122477386ULL, 0x77edf125663c7432ULL, 0x6867a15651b04305ULL,
+		0xf592cf31b758cd24ULL, 0xb669f0d1dedd2e28ULL, 0x8ca1de1c7deafea2ULL, 0x909942274b9b172ULL,
+		0x449df7d0945d7c6ULL, 0xc01adbf218811247ULL, 0xc10bcfe747655eabULL, 0x2e1d1a15ee91c75aULL,
+		0x41cfe0fbc4fc3c46ULL, 0x368bb671fcd0dcabULL, 0xaa3e00eeac2e55fbULL, 0xa06ea8985c782934ULL,
+		0x564bb5206784e31cULL, 0x4b4a4c675825d403ULL, 0x3fc0a672ce011f9aULL, 0xf894b2069ed3baa1ULL,
+		0xb78236ecb3bc7fc7ULL, 0x22028ab89c3bd9d5ULL, 0x1a4baf5a322e6bfcULL, 0x28210b625e28bf1bULL,
+		0xf3e95fedb46b2afeULL, 0x580923e26247e3c8ULL, 0x8dc44786994e29d9ULL, 0xb1f392d67e3942b3ULL,
+		0x873c4851dfcde1dcULL, 0x42fe93d5dbaab15aULL, 0xb26165e06734bbdcULL, 0x42619d700fe8ccc6ULL,
+		0x900b4f50f056a8ebULL, 0x8d71e9d793ad44acULL, 0x415a7734fb443813ULL, 0xe2896f17c14dfcd3ULL,
+		0xdb5c91e1d58193ecULL, 0x562ee5858d0706a9ULL, 0x7749b33661e31373ULL, 0x8ca5e072b1779c58ULL,
+		0x37056d9dd0908885ULL, 0xd05e1df029239db5ULL, 0xe3cfcb291bfedd0ULL, 0xd100e7d72114b9b5ULL,
+		0xaa0fd4d74bce46d7ULL, 0x1ba005cde3a759f5ULL, 0xb7eb75c4d7552f10ULL, 0x9ad08804f3c63ce9ULL,
+		0x584781cc7e12955bULL, 0x8fe04a8b6f754118ULL, 0x8478617a71514673ULL, 0x4a15e97704a221a2ULL,
+		0xc0199e5fd62fb31ULL, 0xd6821937acfa0d14ULL, 0x3a16306f71f1609eULL, 0x87854f5910cbfcc2ULL,
+		0x6b40b6c52eaa0111ULL, 0xc22335df5f82a553ULL, 0x1cd54f7d6b1590aULL, 0xc89e771698361ee2ULL,
+		0xbc6c1a787108417dULL, 0xea4befefeed2ea6aULL, 0x5a4d99192d2db52dULL, 0xca5d09bb770227d6ULL,
+	},
+	{
+		0x9c67809021dbb8f7ULL, 0x1d6bfb0b2aeadb3ULL, 0x117e2265a41e3af6ULL, 0x7e646f83ef7f574aULL,
+		0x9a35cb31619144bULL, 0x935950923b5ebcULL, 0xc11d3b09d3843fe3ULL, 0xdd15e00d40a66863ULL,
+		0x74db9e5cabdb3d65ULL, 0xc0691ee84ad531b1ULL, 0x2943d8af6f18dbabULL, 0xfc9ba5abbdfb7ec3ULL,
+		0xac930cbea81ebe4eULL, 0xf0e4d4e7aea01f97ULL, 0x723e0750a256bcd5ULL, 0xea12dec97762a563ULL,
+		0x42bfa136fb470c95ULL, 0x22a9d11eeaf9dd00ULL, 0xec2b57abad69be5ULL, 0x581e3f1e9f98734ULL,
+		0xf515a4ad972533b0ULL, 0x58f3fce7352f740eULL, 0x31325cf02ae8527ULL, 0xd38a8cdeb00ec899ULL,
+		0x35ed9cce51cafbULL, 0xbfaec149d824aa9dULL, 0x2d9344d7980e1ea0ULL, 0xb5fe23b9c74b013ULL,
+		0xebb8dcb72a9610d2ULL, 0xe885e97def050487ULL, 0x9539649e72c08486ULL, 0xf39d2f24c62fb8bfULL,
+		0x38181065da35c1d0ULL, 0x3c058fe39cde9d71ULL, 0x15abe19d426d9585ULL, 0xccd957269fe4bebdULL,
+		0x5e456f05da713295ULL, 0xa40b9264a8d71050ULL, 0x519bacab1bb9ca5bULL, 0xdcadb6dbd56d7843ULL,
+		0xbc8d2e831392b4a6ULL, 0x55ef9eafbb3ccec0ULL, 0xd2617334124b6e15ULL, 0x889383e0da3753afULL,
+		0x350b01c11c827908ULL, 0xad971ea9f0a64b9bULL, 0xc22bcea6460b9f2ULL, 0xd9589d6bb89933aaULL,
+		0xf235f49c27a4f6d2ULL, 0x97eb1f74aca9fdf1ULL, 0x3fae2efdd6b174b2ULL, 0x9c63d02eade2ff56ULL,
+		0x1b53d4a260f4c976ULL, 0x5c6bb8c4b1d51ca0ULL, 0x1a62543c3eebd7d6ULL, 0x80f8cda7d0a288cdULL,
+		0x509562db09123352ULL, 0xc71e98e16435977fULL, 0xec47425150958fa4ULL, 0xf8f6c1042f59719fULL,
+		0x28c845d482d5c643ULL, 0x56a4fb6dde1b056cULL, 0x33433c7cdeebb9dfULL, 0x4197c5087894d2c6ULL,
+	},
+	{
+		0xaa89ee3616b2696bULL, 0x85e9ff5f7b408003ULL, 0xc86eeae8cecbdb16ULL, 0x6d4c16105075f7f2ULL,
+		0xba07c9b7292a73cbULL, 0x8f3268d70f8b7a44ULL, 0x23fcc18404a3068bULL, 0x790cce85d125f85ULL,
+		0xf62e8b1af6bd3e7eULL, 0x75cc02968c803278ULL, 0x4f7bf90188bacef6ULL, 0xe5e3fecfaa58539ULL,
+		0x2f55ebc6ce5db424ULL, 0xdfc2972ba6daac11ULL, 0x3901786209821492ULL, 0x65b4d987cbf06a61ULL,
+		0x233010965342f61eULL, 0x421636dfbd754d7eULL, 0xa4e72b5cad632711ULL, 0x6f57c65117dcc97eULL,
+		0xbd29e61468e9bf4ULL, 0x18eba022e4a0e9a2ULL, 0xb6fe1612ca0acb27ULL, 0xb7d8295c32275247ULL,
+		0xfe5cd90d412bd652ULL, 0xb831691199f6595dULL, 0x56ecbe6a85fb008aULL, 0xe467bafb4c0a0046ULL,
+		0xc762fb58cc7a4acbULL, 0x3c662857e29f4d9eULL, 0x289cac99518d1ceaULL, 0xf4a282a8f09aeaacULL,
+		0x4d728d1da98a8f69ULL, 0x150c90dabf606da4ULL, 0x21fae041d245514cULL, 0x4e9f138b57fb7424ULL,
+		0xf3efa7e0aae5c239ULL, 0x36f951ef77ef4a50ULL, 0xc84107615bfb3cd1ULL, 0xfc5ef91de7dbac66ULL,
+		0x9d206a9d13d1d2dULL, 0x8733e1b9024fa48dULL, 0x95e1b10513e438feULL, 0x8de3b1aab31713c2ULL,
+		0x5be603bb1cbb322ULL, 0x7371e49df88486e2ULL, 0xefe03683a358d43ULL, 0x4d7da3df59592afcULL,
+		0x4e46d2a041869078ULL, 0x21f3bfa17d2b9511ULL, 0x33c9b6aeb21525b5ULL, 0x5140eda3ce5788ecULL,
+		0x2bd0551fb927d6c6ULL, 0x28739c33d943359eULL, 0x202e67e7831206beULL, 0x8dee483d124723ccULL,
+		0xe0876c3adcbf5ddeULL, 0xd2c7dd1d4a4e705ULL, 0x1e6ec80a48858b4dULL, 0xa9fad798a50a7f0fULL,
+		0x86b788652cdbec87ULL, 0xc58df2f7bffb77dcULL, 0xf2c5bc1c7d7fc295ULL, 0xa00344ea9e823672ULL,
+	},
+	{
+		0x26fb3e61451a01b4ULL, 0x478c60ab74e606bdULL, 0xf3b42e04601c6ec1ULL, 0x40340eb099768800ULL,
+		0x175879e720095dbeULL, 0x100e9388bb59772ULL, 0x2f7ba67b50896528ULL, 0xd24e5acba311f984ULL,
+		0xee922c015ca3e86eULL, 0xf06b2efc819791b1ULL, 0xe191d9319b18d9d0ULL, 0x7138fa38d3f239fbULL,
+		0xe76bf33ee706094aULL, 0x4f6d060d83cb6877ULL, 0xfd9df0c0150fafe4ULL, 0xedd6a2e5a19dbfc8ULL,
+		0x832083cbaa733a32ULL, 0x58123d1c60e89a6eULL, 0x986a7bab4fc21968ULL, 0x926d26fde78c75e9ULL,
+		0x8d94e9e6e139a61cULL, 0xe6bb169303131cc0ULL, 0x40dd5f438660f19ULL, 0xf2c6245b19a74f4aULL,
+		0xd9145f75f78af5deULL, 0x576b0be485015193ULL, 0x78ebafc2eb1f410bULL, 0xaf4f226cb9a1a397ULL,
+		0x2442ce53e4422cddULL, 0x91ea3ad7073ba585ULL, 0x8f66a77570f21fddULL, 0x3ec9a6ebf0e0b738ULL,
+		0xeaac954689013348ULL, 0x652d32a28b0cdcd4ULL, 0xc1179e9b5429d1ffULL, 0xbe79c7ce073ea2daULL,
+		0xedf596c0a2ac34f5ULL, 0x962434c163c74e92ULL, 0xd0dd806cd20d34f2ULL, 0x2ad04b17a68b4c60ULL,
+		0xbe2b9f01a1bf546dULL, 0x996c52053ae52fe7ULL, 0x740b48d70b29950ULL, 0x585bb3fd72c9b9ceULL,
+		0x329e343d3078253fULL, 0x58de5aa3bb7af670ULL, 0xdb8ab4cd92d3fff9ULL, 0x3d8987fe5c97184ULL,
+		0x6cf9cacab66e2998ULL, 0x957ab8444ac4c6a7ULL, 0x5e43c3277dec2b61ULL, 0xbb87375f487d1ba9ULL,
+		0xf87ad7dd7b5bfd45ULL, 0x8ac052203fce4f28ULL, 0xa6807ad974b37c7ULL, 0x4c4b7baa6464292cULL,
+		0x3bca04199e8327abULL, 0x5b18e5417217ec76ULL, 0xde4ebaf4319bc222ULL, 0xe4ccc9c5173b5996ULL,
+		0xf0e72beaa6e7a31aULL, 0x8458f7fb9a6ff014ULL, 0x76bd62858aa75409ULL, 0x95ca61fffb45a499ULL,
+	},
+	{
+		0x4ce6f6f39a90416bULL, 0x4cec8d19b2e04109ULL, 0xa7904be89eaec54fULL, 0x799f257e9aceb66aULL,
+		0xa109b6a3c667647cULL, 0x2ce874930fdfd20cULL, 0x642c9f1c416dbd3bULL, 0x7d0e54353961c123ULL,
+		0xabe9cd81b4661969ULL, 0x84441c75eb15e8c9ULL, 0x626a421bcc668e10ULL, 0xbf5e32fe26b37132ULL,
+		0xf4804ea2fea4cdddULL, 0xca0e65add4b602e9ULL, 0x32f83b63425490a0ULL, 0xae463d54a9b6cb8bULL,
+		0xdb28aa51e7adbef4ULL, 0x940991d182048428ULL, 0x3de4e1692d7b5368ULL, 0xb755ccf43b045cf1ULL,
+		0xf4fc9cdb02a90210ULL, 0x19f6c1b29bdd412dULL, 0x5c0408b6122aa430ULL, 0x7232011d01298504ULL,
+		0x226ad8b4c28b7a86ULL, 0x829ea3f17d56e517ULL, 0x2f991824f3be0658ULL, 0x1bd0034a8a04d4b6ULL,
+		0x3b015a02f5f08acULL, 0xdee6eea11042792aULL, 0x1fec61ffd9a34a3fULL, 0x25fcc84e99a131f3ULL,
+		0xc18dc76f0c61302eULL, 0x7ba1a5badb4bd1a8ULL, 0x201bf5cbf48163f1ULL, 0xf6ffe96aed077972ULL,
+		0x4c25d3329f98fe9aULL, 0x79583b7de08afc74ULL, 0xb94d55e355be6242ULL, 0xc79606d79b927941ULL,
+		0xe10650dee4299402ULL, 0xdc7eaa2feade5232ULL, 0xa9769de6fa0f4ce4ULL, 0x3e1be6e7350a2ac8ULL,
+		0x56ae8e3de05b1b1ULL, 0x686ba6d0db6c8e4aULL, 0x21fa5f9e1de7aee2ULL, 0xd09759d22a566993ULL,
+		0x4887460bc004cf15ULL, 0x87a2a72b4a44939fULL, 0x83f30c39f28adfcdULL, 0xaab06d0475061092ULL,
+		0x5db6a7a6226c4bedULL, 0x8034368763978fc2ULL, 0x218125190acb39baULL, 0xfd7f5bf522870700ULL,
+		0x5363ebb90d967ea9ULL, 0x4636e4b10d30546fULL, 0xd0621fb75a500c60ULL, 0xaa68d53bcf174b9cULL,
+		0xf315b29ee49c109cULL, 0xcbda1a0d11dfc543ULL, 0xd5557c9f463d3b2aULL, 0x5033757e0a1b02ULL,
+	},
+	{
+		0xb3ab4973af5f0fd6ULL, 0xa9710e533969b6d6ULL, 0xea6d56373b32d366ULL, 0x930a44fea981e299ULL,
+		0xda4b59ed1ab71b62ULL, 0x845f5f4bae6a6f9bULL, 0x17eca9fa7914a9b0ULL, 0x64efc48f5f4161cbULL,
+		0xc1c785189f7aca35ULL, 0xdddb646207dfe4cfULL, 0xe7d66edca130a523ULL, 0xa7dcb6f294b7a2e7ULL,
+		0x6a87e8cf590c8c89ULL, 0x602eb471b1ade8a1ULL, 0xaa8c10187b116234ULL, 0x8c3a90e56ab5d1b5ULL,
+		0x32f1d7dff58ff1c6ULL, 0x442ec30ab600b729ULL, 0x7fcc3f8c27babd09ULL, 0x18d95cba0a24ad84ULL,
+		0x7147f592df003715ULL, 0x591818342ae10ab3ULL, 0x9073558dba92ebe9ULL, 0x694f11d83bb6a18cULL,
+		0x3390a4a8bbb14b4eULL, 0x5766babff7215df2ULL, 0x2a2adc62fee7ef2ULL, 0x6c0581e54899a224ULL,
+		0x71b8b38bc4a43c08ULL, 0xde356fa77371b0adULL, 0xad42f92285f769d0ULL, 0x8ca9126c0167bebdULL,
+		0x76a278aa76f9af49ULL, 0xff210302118cbda7ULL, 0xdb09f7c8d931dfe8ULL, 0xe4136da5eaaff746ULL,
+		0xd272966bb4eedd3aULL, 0xcfb22be50436e25bULL, 0xedc305a392bfb722ULL, 0xd6e78ea5611e1643ULL,
+		0x21ae59499e9128acULL, 0x90acdbf3659d0bffULL, 0x1772f0c777f8281bULL, 0x272db9de7573f1f2ULL,
+		0x991bedc1326a180aULL, 0xc0f39e8654d6f477ULL, 0xde280917a6661439ULL, 0xd99fd973affe194aULL,
+		0x63fb85c1089f0974ULL, 0x28d89b8842039232ULL, 0x24545c1150448c8ULL, 0xc67d318d6883aae7ULL,
+		0x7207768a4585f42eULL, 0xacd11d0cd878a707ULL, 0xe9a13dcdfbf209feULL, 0x1dea73c19958e7abULL,
+		0x222572466a26fa67ULL, 0x740275e1222a6868ULL, 0xca663c3eb5c51984ULL, 0xaebd2a5155d8239aULL,
+		0xfb4e0693fc8f1d25ULL, 0x1222f3fa1b2d6928ULL, 0xabf41b918f8629bfULL, 0x3308140022538975ULL,
+	},
+	{
+		0x7af3a5ae2486168eULL, 0xfcaa541716baf5acULL, 0x7d41c370fd9577b9ULL, 0x9175c9a016f76637ULL,
+		0x8d20439507e50fe9ULL, 0x8d2c7eb3ec82fd66ULL, 0x6efc20ca10fc7991ULL, 0xd1014793301a9087ULL,
+		0xc4ec0420deb41fd5ULL, 0x2fcd3c5c5774ec19ULL, 0x7ea48918f204249fULL, 0x827015ca4f9dac98ULL,
+		0xe4578a791068ccb8ULL, 0x796c6ce75eec001eULL, 0x9192dbd8b998ce6dULL, 0xd1af73dc41cf95b1ULL,
+		0xd297390e8112a547ULL, 0x31db962b07560104ULL, 0x8bda4d98d824a2c8ULL, 0x83bd28d5f3fc3aa4ULL,
+		0x61fbc870aaa11023ULL, 0x31c68f327a34f9c4ULL, 0x9a02f9342c2d9ea0ULL, 0xc255ae1979073c78ULL,
+		0x22259746a737ec26ULL, 0x49548e4093b5576aULL, 0xa11c55c4d492b62cULL, 0xb40b6cb66978950ULL,
+		0xad9aa643d9056e98ULL, 0x3682744882b11469ULL, 0xb09a06c9d55c9e50ULL, 0xece5f895ae2dc383ULL,
+		0xe08608a16059cc58ULL, 0xef7cd4b423049a20ULL, 0xeda42a1558b5c058ULL, 0x568b96dfceb23f2ULL,
+		0x7acef346e7e8645bULL, 0xc9a07d2701c381b1ULL, 0x26e7e523bd653ca4ULL, 0x8edba16e97fcbaecULL,
+		0x5ba807270a9b20e9ULL, 0xaf24d3d5163bbd02ULL, 0x965268a1e06db46aULL, 0xd7384d396821ed27ULL,
+		0x273e93f7c1beb85cULL, 0x81694566d6b1b3c7ULL, 0xaf3fb813a3697e33ULL, 0xa7bcfeff700d360bULL,
+		0xde4b676571905deULL, 0xb115e2044fe8202dULL, 0xbe18b5358f877aecULL, 0xa57e6f8ccf4ea830ULL,
+		0x8f8bce4b0910fe98ULL, 0x5d4237a59bd6fe7cULL, 0x5b297fa7533bffcbULL, 0x6b1f39b5685ca295ULL,
+		0xefeab9e68232a4ccULL, 0xd278dfbdd2d8aaddULL, 0xab8f499426e5194dULL, 0xc7b0d6695dab6438ULL,
+		0x21c141bdaf2bc2ebULL, 0xfe409f17699f96feULL, 0x80f04429ae89db16ULL, 0xf9884650d4077163ULL,
+	},
+	{
+		0x658e4e79b83f54b2ULL, 0x85a32b47fef63603ULL, 0x8240604f12e4d56eULL, 0xb7113c23263fd7e2ULL,
+		0xf21af4afd5f0e855ULL, 0xd9c57f4bf0f6a656ULL, 0x37b874ca9a847242ULL, 0x90ad0b982a1f2786ULL,
+		0x8d6d33e7bd634dcbULL, 0xba13cbd667092d6fULL, 0xd37c10a416c29427ULL, 0xda3c1904e9c4c524ULL,
+		0xf4c3c0ea66ef39d8ULL, 0x7aa9ba41515ea367ULL, 0xdd6632e42d6e7258ULL, 0x65c54e1e7720c2f2ULL,
+		0xf62b7431097b2f6cULL, 0xcb7d2acc89aa460bULL, 0xb127eacad3a7625bULL, 0x7ffedf451720204ULL,
+		0x4c917ba1e3399a36ULL, 0x8aa628b9f5b520b5ULL, 0xc4e3ecb8e975602cULL, 0xa1344f8b9a42096dULL,
+		0xe14fb0b38471729fULL, 0xf2595a64e1085742ULL, 0x1a089a33a4b41f68ULL, 0xaa1c42c33e81855dULL,
+		0xad16d9793aba5d25ULL, 0x10abdd3a72210d64ULL, 0x5247e5da75861fdaULL, 0xafefb337ddd6e5a5ULL,
+		0xf67f80f41a939f40ULL, 0x82fb458923bfc4c2ULL, 0x5046cbd3d2d6a365ULL, 0xa6f2c75086f5b569ULL,
+		0x1b9e462499d4c92fULL, 0xf69dba6c94e5c054ULL, 0xb5b3df91397a249bULL, 0x4c7a833d7b36e969ULL,
+		0x87ce9d704b2f6bfeULL, 0x2c4ef365d2ed40bULL, 0x18d025ff50cdb3bbULL, 0xd4b0a016931c4aa0ULL,
+		0x38e44362aae303bdULL, 0x3b4041631aba0595ULL, 0xff8f22601d387a57ULL, 0x79f96332a1da8b3dULL,
+		0xc1c56acbaf169d5ULL, 0xe430b8da1eaae52cULL, 0xdfac40a4f49ee99fULL, 0x5125c5ce17b26ed2ULL,
+		0xcbb802df50e6a307ULL, 0x39753bc0568d7c6ULL, 0xff440b44a395d00aULL, 0x33faaf83325957f9ULL,
+		0xe210f8e527991e6cULL, 0x1db75414bdc5707aULL, 0x24d21451c52d4485ULL, 0xe8fb9dbf17df5f67ULL,
+		0x14af44f64ee4bc45ULL, 0xa19be695809307fbULL, 0xb67290c3075db5f5ULL, 0xb8601ed757750152ULL,
+	},
+	{
+		0xd28563aabeaf2f25ULL, 0x6b75e796db893414ULL, 0xe0ed28cb1d0d990cULL, 0x87e46fb2a6099a50ULL,
+		0x911caa9aa785ce86ULL, 0x1b8a1eaf4f63dbb7ULL, 0x2587902343a9f3aULL, 0x1bab76a98c2dab8eULL,
+		0x1807867992c328dbULL, 0xf0d861b6416a5f9bULL, 0xc5b3d8b278c2b665ULL, 0x840105eb23117c82ULL,
+		0x699e5cc713c21544ULL, 0x4c497878a497a136ULL, 0xa52881ba65b9c4d4ULL, 0xa2b25ff51214fbadULL,
+		0xa0b7ed7bb7d170fdULL, 0x6f5b0175175a3829ULL, 0x5d49756b3b888f73ULL, 0x5804aa745f4d440dULL,
+		0xd3a8ce9aed3437a8ULL, 0x4c960e23fd26bf57ULL, 0x9483c44f13fdb2a8ULL, 0x5af89e6a4cbfe003ULL,
+		0xd205e14c7125651eULL, 0xffc8ff578d323553ULL, 0xd7474a6689c21763ULL, 0x479c4708a39d76e1ULL,
+		0xd43a8ad9c68dcd2eULL, 0x557b6290e63d92e0ULL, 0x520cd54a8b453c23ULL, 0x4d9d0449fc27cd01ULL,
+		0xee12efff860235a3ULL, 0x9df8335975add26aULL, 0x24331ea979763f95ULL, 0x3a4310fe431b87ULL,
+		0x5159cf025674b696ULL, 0xf38dd0d45b48c85eULL, 0xfda91b8b83202658ULL, 0xb78843350f2d0c6eULL,
+		0x109eaf35fe75ad4aULL, 0xd33bc557e58eab7dULL, 0xc2d67bbccc526897ULL, 0x1091c036030451b8ULL,
+		0x65ba8e0f90af41dfULL, 0x9431bc06e6e6c8d0ULL, 0x34e126cf0d5b327bULL, 0x1e5f6689a12355ecULL,
+		0x85a44216c20fb265ULL, 0x9a994e024b1c486ULL, 0xe46d2fd45824031dULL, 0xf9b4b001e81774b2ULL,
+		0x7b127255a87d7572ULL, 0xd5a58d4e399b172ULL, 0x5adf16cdae6df2a4ULL, 0x3e41f0d8112ff438ULL,
+		0x6d1f2b4f1f94965aULL, 0xcf5b0a686b282fd6ULL, 0xfba54d8a8973ca52ULL, 0x8f187f71071ba7e8ULL,
+		0x6f40d663b5a4b322ULL, 0xb8d491e240b19527ULL, 0xed9dd11b7f9dcb25ULL, 0xb7a76c4b2f8413eULL,
+	},
+	{
+		0xddb670de69290e99ULL, 0x3145179bf9db4b06ULL, 0x91c2f90b614b636aULL, 0xe5568ba08a8740f1ULL,
+		0xda8309ad37d3cd0dULL, 0x9be575b56f5b9c84ULL, 0x952f939cc80e40e1ULL, 0xc2f557138425a666ULL,
+		0xc8d4eed88560d5f5ULL, 0xc036d0048d56905bULL, 0x878de84401501fc1ULL, 0x46a141d3e1ae03c4ULL,
+		0x9453aad22ee07415ULL, 0x30f54c2dd0dc7244ULL, 0x8ced92539b54dfc6ULL, 0xea18caf21e0de96fULL,
+		0x45ffaa38a29d446cULL, 0xc6e104aad711863eULL, 0xde10ee625fbc0f54ULL, 0x53ef6878ec9e341bULL,
+		0xca72b17c91e0a2c7ULL, 0xee5428fbe02a2ac0ULL, 0x51370838bc8f71f6ULL, 0x879e31f04b42a29fULL,
+		0x1972543ca87ddd01ULL, 0x7e92214eacea806bULL, 0x3efb61f488789fc0ULL, 0x8357a5a1e9a16898ULL,
+		0xe1778e73dd4937c3ULL, 0x2557bcc2e237be6fULL, 0xacae0fb5dbba2e43ULL, 0x88835d3e2e09902fULL,
+		0x919456ddcc4810b0ULL, 0xda3c97c0ea221f5ULL, 0x86f16b7f0f8bcca4ULL, 0x625891945b07fe9bULL,
+		0x2c145fb28ae20fbfULL, 0x78155aa6eb8a00a9ULL, 0x28e56030aaf97841ULL, 0xa6f573709ab0f08aULL,
+		0xd61ebb0ebd8bd748ULL, 0xf159c1f0846a0c2bULL, 0x8255769fca40b66cULL, 0x41c244ab2ce8b4fdULL,
+		0x1ae5e40f6eb37c39ULL, 0x206284d18a1eb091ULL, 0xc08e105419305d95ULL, 0x9da07ef6e58bd817ULL,
+		0x8dfb974791d85d36ULL, 0xa84df50d1e4dc31fULL, 0xdcc02e79be44338bULL, 0x1964a6aaa45d4e14ULL,
+		0x84386662a3c4cec1ULL, 0x1d8cd8d2f78f4a18ULL, 0x9f1998a28bfaab57ULL, 0xbdb74c1421665ee0ULL,
+		0xbf0d1845d0fd41d4ULL, 0x27323394c55fa493ULL, 0x9a4401298742560dULL, 0x321640421f69d2d8ULL,
+		0xe5da957e1bc5b100ULL, 0xb4b83894284e80a6ULL, 0xdc8562697242f3aULL, 0xf5dc7904726406b8ULL,
+	},
+};
+
+static const u64 zobrist_castling[16] = {
+	0x0ULL, 0x401a18bb02d7d7f0ULL, 0x2e25432d34843d62ULL, 0xde7f81c36fcc98f6ULL,
+	0xbb1d72e273e1851cULL, 0x5fa89bb1b31ce65fULL, 0x6433f7bf0e7c5397ULL, 0xbcf3f8f495dcf4dfULL,
+	0x9537d604dd15b57bULL, 0x96aa2e26a64e4df8ULL, 0xb3232085710c0949ULL, 0x21ba00c4b1e95666ULL,
+	0x5445b23b201e4b8bULL, 0x2bc56107164766deULL, 0x8b3f6cb323389c02ULL, 0xa4a8aca7f1e9481cULL,
+};
+
+static const u64 zobrist_ep[SQUARES_NONE + 1] = {
+	0xfd2eb571541c44bdULL, 0x6a20d0039ce9e8cbULL, 0x54cb2be39074cb40ULL, 0xc8b66b6df6c4f726ULL,
+	0xe1257c0e4f72d914ULL, 0x11fe7ccb337fc37fULL, 0x6bb3a99c0db32cc1ULL, 0x5c28befe9d580cccULL,
+	0xfdca49f93af2142bULL, 0x5fb1fe2b5f16a74bULL, 0x455d466ffc69413cULL, 0x50fdb01e027337a6ULL,
+	0x24ede0fde80a707ULL, 0xb00b99046dad1a4ULL, 0x430656323cc37deeULL, 0x24a53eaddf2d4ee6ULL,
+	0xa08375fbf81ebedeULL, 0x34917542e7cdf6e8ULL, 0x4c2ef16681337685ULL, 0xbc1103c8dc5ce9e4ULL,
+	0xccbebee7aac3ee0dULL, 0xd802aa4213bebb7fULL, 0xb7db8438ad034aa3ULL, 0x25e0b143b1aa87c3ULL,
+	0x7350ddc1d8cfd3f5ULL, 0xa76d82a80b684023ULL, 0xb38e7c4a01e93486ULL, 0xbe2b801429bda56eULL,
+	0x64c252bb7fd54bb6ULL, 0xcca6ce02211cbabbULL, 0xd5e297305514e035ULL, 0xd6369c83eeff302eULL,
+	0xdd2698647925864bULL, 0x186a02ef88eabc64ULL, 0x7b79ddcd0c082d86ULL, 0x47566145125e5576ULL,
+	0x53d98a366291ab50ULL, 0x2f107b113a86dd6bULL, 0x353a695a3b58dcf3ULL, 0xb0134a5487bbc6dULL,
+	0xa29e2e0cefea5a7bULL, 0x23c282e21f34243dULL, 0xde04830ce616056eULL, 0x8648ea5d20965ed5ULL,
+	0x56ab8ebbc39739c4ULL, 0x5c147387b04c82b8ULL, 0xb7023a3aa84d9d1bULL, 0x704fe415179f429cULL,
+	0x167850358f7b6f08ULL, 0x80431556fff75cfbULL, 0xc191b056bb6245e3ULL, 0x9b81c95c70b5d1b0ULL,
+	0x2c29b32a806fa5c7ULL, 0x2b37b9e6928f3d33ULL, 0x1df3ec7b0cc5e49fULL, 0xb739fa4c497a441dULL,
+	0xc496409f5b8861d7ULL, 0xe3c89673c82a1a38ULL, 0x18b79fa0e87c26feULL, 0xe9a52b736ee8f531ULL,
+	0x3b5c802526d2b597ULL, 0x745ff24be2c9481ULL, 0x3c2928ef1ada42b6ULL, 0xbbd208dfb35196ccULL,
+	0,
+};
+
+static const u64 zobrist_side = 0x1e38ed03e3c60bfaULL;